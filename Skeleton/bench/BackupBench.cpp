@@ -0,0 +1,75 @@
+#include "Benchmarks.h"
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+string formatMegabytes(const size_t bytes) {
+    ostringstream formatted;
+    formatted << fixed << setprecision(2) << bytes / 1e6 << " MB";
+    return formatted.str();
+}
+
+}
+
+// What a backup costs, by number of plans (stepped 300 times first): a snapshot, which shares the state, against a deep
+// copy, made here by saving an image and loading it into a simulation of its own. For each: the time to take it, then
+// after one more step the memory it holds on its own and the time to restore it.
+void benchBackup() {
+    char directory[] = "/tmp/simulation-bench-XXXXXX";
+    if (::mkdtemp(directory) == nullptr) {
+        throw runtime_error("Unable to make a temporary directory");
+    }
+    string path = string(directory) + "/backup.img";
+    printRow({"plans", "state", "snapshot", "holds", "restore", "deep copy", "holds", "restore"});
+    for (int numOfPlans : {200, 2000, 10000}) {
+        Simulation *simulation = makeSimulation(numOfPlans, {"nve", "bal", "eco", "sus"});
+        simulation->step(300);
+        vector<string> row = {to_string(numOfPlans)};
+
+        SimulationSnapshot *snapshot = nullptr;
+        double snapshotTime = timeRuns([&]() { snapshot = simulation->takeSnapshot(); }, [&]() {
+            delete snapshot;
+            snapshot = nullptr;
+        });
+        size_t stateBytes = 0, totalBytes = 0;
+        snapshot->measure(stateBytes, totalBytes);
+        row.push_back(formatMegabytes(totalBytes));
+        simulation->step(1);
+        size_t snapshotBytes = 0, snapshotTotalBytes = 0;
+        snapshot->measure(snapshotBytes, snapshotTotalBytes);
+        double snapshotRestoreTime = timeRuns([&]() { simulation->restore(*snapshot); }, [&]() { simulation->step(1); });
+        row.push_back(formatTime(snapshotTime));
+        row.push_back(formatMegabytes(snapshotBytes));
+        row.push_back(formatTime(snapshotRestoreTime));
+        simulation->restore(*snapshot);
+        delete snapshot;
+
+        Simulation *copy = nullptr;
+        double copyTime = timeRuns([&]() {
+            simulation->save(path);
+            copy = new Simulation(configurationPath);
+            copy->load(path);
+        }, [&]() {
+            delete copy;
+            copy = nullptr;
+        });
+        SimulationSnapshot copied(*copy);
+        size_t copyBytes = 0, copyTotalBytes = 0;
+        copied.measure(copyBytes, copyTotalBytes);
+        simulation->step(1);
+        double copyRestoreTime = timeRuns([&]() {
+            copy->save(path);
+            simulation->load(path);
+        }, [&]() { simulation->step(1); });
+        row.push_back(formatTime(copyTime));
+        row.push_back(formatMegabytes(copyTotalBytes));
+        row.push_back(formatTime(copyRestoreTime));
+        printRow(row);
+        delete copy;
+        delete simulation;
+    }
+    ::unlink(path.c_str());
+    ::rmdir(directory);
+}
@@ -0,0 +1,104 @@
+#include "Benchmarks.h"
+#include "Action.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <utility>
+
+SimulationSnapshot *backup = nullptr; // The backup the actions share, as main.cpp defines it for bin/simulation
+const char *const configurationPath = "config_file.txt";
+
+Simulation *makeSimulation(const int numOfPlans, const vector<string> &policies) {
+    Simulation *simulation = new Simulation(configurationPath);
+    for (int i = 0; i < numOfPlans; i++) {
+        string settlementName = "Settlement" + to_string(i);
+        AddSettlement(settlementName, static_cast<SettlementType>(i % 3)).act(*simulation);
+        AddPlan(settlementName, policies[i % policies.size()]).act(*simulation);
+    }
+    return simulation;
+}
+
+void runCommands(Simulation &simulation, const vector<string> &commands) {
+    string text;
+    for (const string &command : commands) {
+        text += command + "\n";
+    }
+    istringstream input(text + "close\n");
+    ostringstream output;
+    streambuf *previousInput = cin.rdbuf(input.rdbuf());
+    streambuf *previousOutput = cout.rdbuf(output.rdbuf());
+    try {
+        simulation.start();
+    } catch (...) {
+        cin.rdbuf(previousInput);
+        cout.rdbuf(previousOutput);
+        throw;
+    }
+    cin.rdbuf(previousInput);
+    cout.rdbuf(previousOutput);
+}
+
+double timeRuns(const function<void()> &run, const function<void()> &prepare) {
+    const chrono::steady_clock::duration minDuration = chrono::milliseconds(250);
+    chrono::steady_clock::duration elapsed = chrono::steady_clock::duration::zero();
+    long long numOfRuns = 0;
+    while (elapsed < minDuration) {
+        if (prepare) {
+            prepare();
+        }
+        chrono::steady_clock::time_point start = chrono::steady_clock::now();
+        run();
+        elapsed += chrono::steady_clock::now() - start;
+        numOfRuns++;
+    }
+    return static_cast<double>(chrono::duration_cast<chrono::nanoseconds>(elapsed).count()) / numOfRuns;
+}
+
+void printRow(const vector<string> &columns) {
+    for (const string &column : columns) {
+        cout << left << setw(14) << column;
+    }
+    cout << endl;
+}
+
+string formatTime(const double nanoseconds) {
+    const pair<double, const char*> units[] = {{1e9, " s"}, {1e6, " ms"}, {1e3, " us"}};
+    ostringstream formatted;
+    formatted << fixed << setprecision(1);
+    for (const pair<double, const char*> &unit : units) {
+        if (nanoseconds >= unit.first) {
+            formatted << nanoseconds / unit.first << unit.second;
+            return formatted.str();
+        }
+    }
+    formatted << nanoseconds << " ns";
+    return formatted.str();
+}
+
+// Runs the benchmarks named on the command line, or all of them, from the directory of the makefile (see 'make bench')
+int main(int argc, char **argv) {
+    const pair<const char*, void(*)()> benchmarks[] = {
+        {"Backup", benchBackup},
+        {"Compare", benchCompare},
+        {"Facilities", benchFacilities},
+        {"Load", benchLoad},
+        {"Replay", benchReplay},
+        {"Resume", benchResume},
+        {"ScoreIndex", benchScoreIndex},
+        {"Step", benchStep},
+        {"Wal", benchWal},
+    };
+    for (const pair<const char*, void(*)()> &benchmark : benchmarks) {
+        bool isChosen = argc == 1;
+        for (int i = 1; i < argc; i++) {
+            isChosen = isChosen || strcmp(argv[i], benchmark.first) == 0;
+        }
+        if (!isChosen) continue;
+        cout << benchmark.first << endl;
+        benchmark.second();
+        cout << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include "Simulation.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace std;
+using std::string;
+using std::vector;
+
+// The configuration the benchmarks that run whole simulations start from, in the makefile's directory
+extern const char *const configurationPath;
+
+// The configuration's simulation with numOfPlans more plans, on new settlements of every type, the policies taking turns
+Simulation *makeSimulation(const int numOfPlans, const vector<string> &policies);
+
+// Enters the commands as a user would, through the simulation's prompt, and drops what it prints
+void runCommands(Simulation &simulation, const vector<string> &commands);
+
+// Mean time of one call of run, in nanoseconds: run is called until it has taken about a quarter of a second.
+// prepare, if given, is called before each run, outside of the time measured.
+double timeRuns(const function<void()> &run, const function<void()> &prepare = nullptr);
+
+// Prints a table row, every column the same width
+void printRow(const vector<string> &columns);
+
+// A time in nanoseconds, in the unit that suits it
+string formatTime(const double nanoseconds);
+
+// The benchmarks, one file each
+void benchBackup();
+void benchCompare();
+void benchFacilities();
+void benchLoad();
+void benchReplay();
+void benchResume();
+void benchScoreIndex();
+void benchStep();
+void benchWal();
@@ -0,0 +1,56 @@
+#include "Benchmarks.h"
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+namespace {
+
+const vector<string> policyNames = {"nve", "bal", "eco", "sus", "opt"};
+
+// The plan forked once per policy, as compare forks it
+void forkPlan(Simulation &simulation, const Plan &plan, PlanStorage &forks) {
+    for (const string &policyName : policyNames) {
+        if (policyName == plan.getSelectionPolicy()->toString()) {
+            forks.add(plan);
+        } else {
+            forks.add(plan).setSelectionPolicy(simulation.createSelectionPolicy(plan, policyName));
+        }
+    }
+}
+
+}
+
+// What compare costs, by how long the plan ran before (so how many facilities it holds): forking the plan once per
+// policy, then stepping the forks 100 steps one after the other and on a thread each, as compare does.
+void benchCompare() {
+    const int numOfSteps = 100;
+    cout << "KiryatSPL's plan, compare over " << numOfSteps << " steps, " << thread::hardware_concurrency() << " hardware threads" << endl;
+    printRow({"stepped", "facilities", "fork", "serial", "parallel", "speedup"});
+    Simulation simulation(configurationPath);
+    int stepped = 0;
+    for (int numOfPlanSteps : {100, 1000, 10000}) {
+        simulation.step(numOfPlanSteps - stepped);
+        stepped = numOfPlanSteps;
+        const Simulation &compared = simulation;
+        const Plan &plan = compared.getPlan(1);
+
+        PlanStorage forks;
+        double forkTime = timeRuns([&]() { forkPlan(simulation, plan, forks); }, [&]() { forks.clear(); });
+        double serialTime = timeRuns([&]() {
+            for (size_t i = 0; i < forks.size(); i++) {
+                forks[i].step(numOfSteps, false);
+            }
+        }, [&]() {
+            forks.clear();
+            forkPlan(simulation, plan, forks);
+        });
+        double parallelTime = timeRuns([&]() { simulation.stepForks(forks, numOfSteps); }, [&]() {
+            forks.clear();
+            forkPlan(simulation, plan, forks);
+        });
+        ostringstream speedup;
+        speedup << fixed << setprecision(2) << serialTime / parallelTime << "x";
+        printRow({to_string(numOfPlanSteps), to_string(plan.getFacilities().size() + plan.getFacilitiesUnderConstruction().size()),
+                  formatTime(forkTime), formatTime(serialTime), formatTime(parallelTime), speedup.str()});
+    }
+}
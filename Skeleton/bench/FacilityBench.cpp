@@ -0,0 +1,73 @@
+#include "Benchmarks.h"
+#include <iomanip>
+#include <sstream>
+
+namespace {
+
+// A facility as it was stored before it became a flyweight: a copy of its type, name included, and of its settlement's
+// name, allocated on its own and held through a pointer
+struct CopiedFacility {
+    string name;
+    FacilityCategory category;
+    int price, lifeQualityScore, economyScore, environmentScore;
+    string settlementName;
+    FacilityStatus status;
+    int timeLeft;
+};
+
+// Bytes a string holds on the heap, in libstdc++'s layout (short strings are kept inside the object)
+size_t heapBytes(const string &text) {
+    return text.size() > 15 ? text.size() + 1 : 0;
+}
+
+string formatBytes(const double bytes) {
+    ostringstream formatted;
+    formatted << fixed << setprecision(1) << bytes << " B";
+    return formatted.str();
+}
+
+}
+
+// Memory per facility once 2000 plans have built their facilities: the bytes of the whole state (SimulationSnapshot's
+// measure) over the facilities in it, for facilities kept as flyweights and for compact plans, which only count them,
+// against what the copies of their types and settlement names took before (not counted for compact plans, which don't
+// say which types they built).
+void benchFacilities() {
+    const int numOfPlans = 2000;
+    const int numOfSteps = 300;
+    cout << numOfPlans << " plans, step " << numOfSteps << endl;
+    printRow({"plans", "facilities", "state", "per facility", "flyweight", "copied"});
+    for (bool compact : {false, true}) {
+        Simulation *simulation = makeSimulation(numOfPlans, {"nve", "bal", "eco", "sus"});
+        simulation->setCompact(compact);
+        simulation->step(numOfSteps);
+
+        size_t numOfFacilities = 0;
+        size_t copiedBytes = 0;
+        for (int id = 0; simulation->isPlanExists(id); id++) {
+            const Plan &plan = static_cast<const Simulation*>(simulation)->getPlan(id);
+            size_t planFacilities = plan.getFacilitiesUnderConstruction().size();
+            for (long long count : plan.getOperationalCounts()) {
+                planFacilities += static_cast<size_t>(count);
+            }
+            planFacilities += plan.getFacilities().size();
+            for (const Facility *facility : plan.getFacilitiesUnderConstruction()) {
+                copiedBytes += heapBytes(facility->getName());
+            }
+            for (const Facility &facility : plan.getFacilities()) {
+                copiedBytes += heapBytes(facility.getName());
+            }
+            copiedBytes += planFacilities * (sizeof(CopiedFacility *) + sizeof(CopiedFacility) + heapBytes(plan.getSettlement().getName()));
+            numOfFacilities += planFacilities;
+        }
+        SimulationSnapshot state(*simulation);
+        size_t uniqueBytes = 0, totalBytes = 0;
+        state.measure(uniqueBytes, totalBytes);
+        ostringstream stateBytes;
+        stateBytes << fixed << setprecision(1) << totalBytes / 1e6 << " MB";
+        printRow({compact ? "compact" : "listing", to_string(numOfFacilities), stateBytes.str(),
+                  formatBytes(static_cast<double>(totalBytes) / numOfFacilities), formatBytes(sizeof(Facility)),
+                  compact ? "-" : formatBytes(static_cast<double>(copiedBytes) / numOfFacilities)});
+        delete simulation;
+    }
+}
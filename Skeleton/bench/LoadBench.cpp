@@ -0,0 +1,56 @@
+#include "Benchmarks.h"
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <unistd.h>
+
+namespace {
+
+// Writes a configuration of numOfSettlements settlements, a fifth as many facility types and a tenth as many plans
+void writeConfiguration(const string &path, const int numOfSettlements) {
+    const string policies[] = {"nve", "bal", "eco", "env"}; // As configurations name them
+    ofstream configuration(path);
+    for (int i = 0; i < numOfSettlements; i++) {
+        configuration << "settlement Settlement" << i << " " << i % 3 << "\n";
+    }
+    for (int i = 0; i < numOfSettlements / 5; i++) {
+        configuration << "facility Facility" << i << " " << i % 3 << " " << 1 + i % 5 << " " << i % 4 << " " << i % 3 << " " << i % 5 << "\n";
+    }
+    for (int i = 0; i < numOfSettlements / 10; i++) {
+        configuration << "plan Settlement" << i * 7 % numOfSettlements << " " << policies[i % 4] << "\n";
+    }
+}
+
+}
+
+// Time of loading configurations of growing size, and per line, which stays flat as every line is checked against the
+// settlements and facility types through their indexes. Then the time of a settlement, facility and plan lookup.
+void benchLoad() {
+    char directory[] = "/tmp/simulation-bench-XXXXXX";
+    if (::mkdtemp(directory) == nullptr) {
+        throw runtime_error("Unable to make a temporary directory");
+    }
+    string path = string(directory) + "/config.txt";
+    printRow({"settlements", "types", "plans", "load", "per line", "lookup"});
+    mt19937 random(3);
+    for (int numOfSettlements : {1000, 10000, 100000}) {
+        writeConfiguration(path, numOfSettlements);
+        Simulation *simulation = nullptr;
+        double loadTime = timeRuns([&]() { simulation = new Simulation(path); }, [&]() {
+            delete simulation;
+            simulation = nullptr;
+        });
+        int numOfLines = numOfSettlements + numOfSettlements / 5 + numOfSettlements / 10;
+        double lookupTime = timeRuns([&]() {
+            int i = static_cast<int>(random() % (numOfSettlements / 10));
+            simulation->getSettlement("Settlement" + to_string(i * 10));
+            simulation->isFacilityExists("Facility" + to_string(i * 2));
+            simulation->getPlan(i);
+        });
+        printRow({to_string(numOfSettlements), to_string(numOfSettlements / 5), to_string(numOfSettlements / 10),
+                  formatTime(loadTime), formatTime(loadTime / numOfLines), formatTime(lookupTime / 3)});
+        delete simulation;
+    }
+    ::unlink(path.c_str());
+    ::rmdir(directory);
+}
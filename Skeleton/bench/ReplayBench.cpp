@@ -0,0 +1,42 @@
+#include "Benchmarks.h"
+
+namespace {
+
+const int checkpointInterval = 64;
+
+// A log of numOfCommands commands, mostly single steps, now and then a plan changing its policy
+vector<string> makeLog(const int numOfCommands) {
+    const vector<string> policies = {"nve", "bal", "eco", "sus"};
+    vector<string> commands;
+    for (int i = 0; i < numOfCommands; i++) {
+        commands.push_back(i % 10 == 9 ? "changePolicy " + to_string(i % 50) + " " + policies[i / 10 % policies.size()] : "step 1");
+    }
+    return commands;
+}
+
+// The mean time to restore a backup taken after the log, in the backup mode, one more step after it
+double timeRestore(const vector<string> &log, const BackupMode backupMode, const size_t interval) {
+    Simulation *simulation = makeSimulation(48, {"nve", "bal", "eco", "sus"});
+    simulation->setBackupMode(backupMode, interval);
+    runCommands(*simulation, log);
+    SimulationSnapshot *snapshot = simulation->takeSnapshot();
+    double restoreTime = timeRuns([&]() { simulation->restore(*snapshot); }, [&]() { simulation->step(1); });
+    delete snapshot;
+    delete simulation;
+    return restoreTime;
+}
+
+}
+
+// What a restore costs, by the number of commands logged since the simulation started (50 plans): a snapshot, which
+// holds the state, against a replay backup, which applies the logged commands again from the last checkpoint - the
+// start of the simulation, or one every 64 commands (--checkpoint-interval 64)
+void benchReplay() {
+    printRow({"commands", "snapshots", "replay", "checkpoints"});
+    for (int numOfCommands : {10, 100, 1000, 5000}) {
+        vector<string> log = makeLog(numOfCommands);
+        printRow({to_string(numOfCommands), formatTime(timeRestore(log, BackupMode::SNAPSHOTS, 0)),
+                  formatTime(timeRestore(log, BackupMode::REPLAY, 0)),
+                  formatTime(timeRestore(log, BackupMode::REPLAY, checkpointInterval))});
+    }
+}
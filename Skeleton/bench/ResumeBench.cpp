@@ -0,0 +1,61 @@
+#include "Benchmarks.h"
+#include <iomanip>
+#include <sstream>
+#include <unistd.h>
+
+namespace {
+
+// A campaign of numOfPlans plans on settlements of their own, the policies taking turns, stepped 10 steps after every
+// hundredth plan
+vector<string> makeCampaign(const int numOfPlans) {
+    const vector<string> policies = {"nve", "bal", "eco", "sus"};
+    vector<string> commands;
+    for (int i = 0; i < numOfPlans; i++) {
+        string settlementName = "Settlement" + to_string(i);
+        commands.push_back("settlement " + settlementName + " " + to_string(i % 3));
+        commands.push_back("plan " + settlementName + " " + policies[i % policies.size()]);
+        if (i % 100 == 99) {
+            commands.push_back("step 10");
+        }
+    }
+    return commands;
+}
+
+}
+
+// What resuming a campaign costs, by number of plans: loading its image (--resume) against starting from the
+// configuration again and entering the campaign's commands
+void benchResume() {
+    char directory[] = "/tmp/simulation-bench-XXXXXX";
+    if (::mkdtemp(directory) == nullptr) {
+        throw runtime_error("Unable to make a temporary directory");
+    }
+    string path = string(directory) + "/campaign.img";
+    printRow({"plans", "commands", "resume", "replay", "speedup"});
+    for (int numOfPlans : {100, 1000, 5000}) {
+        vector<string> commands = makeCampaign(numOfPlans);
+        Simulation campaign(configurationPath);
+        runCommands(campaign, commands);
+        campaign.save(path);
+
+        Simulation *resumed = nullptr;
+        auto release = [&]() {
+            delete resumed;
+            resumed = nullptr;
+        };
+        double resumeTime = timeRuns([&]() {
+            resumed = new Simulation(configurationPath);
+            resumed->load(path);
+        }, release);
+        double replayTime = timeRuns([&]() {
+            resumed = new Simulation(configurationPath);
+            runCommands(*resumed, commands);
+        }, release);
+        release();
+        ostringstream speedup;
+        speedup << fixed << setprecision(1) << replayTime / resumeTime << "x";
+        printRow({to_string(numOfPlans), to_string(commands.size()), formatTime(resumeTime), formatTime(replayTime), speedup.str()});
+    }
+    ::unlink(path.c_str());
+    ::rmdir(directory);
+}
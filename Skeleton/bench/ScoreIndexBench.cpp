@@ -0,0 +1,45 @@
+#include "Benchmarks.h"
+#include "ScoreIndex.h"
+#include <random>
+
+// Time of one balanced selection, by catalog size: BalancedSelection's own loop over the catalog against each way
+// the ScoreIndex finds the answer. The scores selected for are drawn anew for each selection, so the index's remembered
+// decisions don't help: what they cost in bookkeeping (on catalogs of 64 types and more) is counted in.
+void benchScoreIndex() {
+    const vector<pair<ScoreIndex::Method, string>> methods = {
+        {ScoreIndex::Method::SCAN_SCALAR, "scalar"}, {ScoreIndex::Method::SCAN_SSE41, "sse4.1"},
+        {ScoreIndex::Method::SCAN_AVX2, "avx2"}, {ScoreIndex::Method::TREE, "tree"}, {ScoreIndex::Method::AUTOMATIC, "automatic"}};
+    const vector<size_t> sizes = {16, 100, 1000, 2048, 10000, 100000};
+    vector<string> header = {"types", "loop"};
+    for (const pair<ScoreIndex::Method, string> &method : methods) {
+        header.push_back(method.second);
+    }
+    printRow(header);
+
+    mt19937 random(7);
+    auto randomScore = [&random]() { return static_cast<int>(random() % 1000000); };
+    for (size_t size : sizes) {
+        vector<FacilityType> catalog;
+        for (size_t i = 0; i < size; i++) {
+            catalog.emplace_back("Type" + to_string(i), FacilityCategory::ECONOMY, 1, static_cast<int>(random() % 1000),
+                                 static_cast<int>(random() % 1000), static_cast<int>(random() % 1000));
+        }
+        vector<string> row = {to_string(size)};
+        row.push_back(formatTime(timeRuns([&]() {
+            BalancedSelection selection(randomScore(), randomScore(), randomScore());
+            selection.selectFacility(catalog);
+        })));
+        for (const pair<ScoreIndex::Method, string> &method : methods) {
+            if (!ScoreIndex::isSupported(method.first)) {
+                row.push_back("-");
+                continue;
+            }
+            ScoreIndex index;
+            index.update(catalog, method.first);
+            row.push_back(formatTime(timeRuns([&]() {
+                index.findMostBalanced(randomScore(), randomScore(), randomScore());
+            })));
+        }
+        printRow(row);
+    }
+}
@@ -0,0 +1,36 @@
+#include "Benchmarks.h"
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
+// Time of a step command of 1000 steps over 2000 plans, by number of threads and stepping core, with the speedup over
+// a single thread. The plans take turns at the nve, bal, eco and sus policies (opt plans cost as much as all of them
+// together, so the few threads that get them would set the time). Each run steps the same plans from the same state, restored before the run.
+void benchStep() {
+    const int numOfPlans = 2000;
+    const int numOfSteps = 1000;
+    cout << numOfPlans << " plans, step " << numOfSteps << ", " << thread::hardware_concurrency() << " hardware threads" << endl;
+    printRow({"threads", "plans core", "speedup", "arrays core", "speedup"});
+    Simulation *simulation = makeSimulation(numOfPlans, {"nve", "bal", "eco", "sus"});
+    SimulationSnapshot *start = simulation->takeSnapshot();
+    double serial[2] = {0, 0};
+    for (int numOfThreads : {1, 2, 4, 8}) {
+        vector<string> row = {to_string(numOfThreads)};
+        for (StepCore stepCore : {StepCore::PLANS, StepCore::ARRAYS}) {
+            simulation->setNumOfThreads(numOfThreads);
+            simulation->setStepCore(stepCore);
+            double time = timeRuns([&]() { simulation->step(numOfSteps); }, [&]() { simulation->restore(*start); });
+            double &serialTime = serial[stepCore == StepCore::PLANS ? 0 : 1];
+            if (numOfThreads == 1) {
+                serialTime = time;
+            }
+            ostringstream speedup;
+            speedup << fixed << setprecision(2) << serialTime / time << "x";
+            row.push_back(formatTime(time));
+            row.push_back(speedup.str());
+        }
+        printRow(row);
+    }
+    delete start;
+    delete simulation;
+}
@@ -0,0 +1,62 @@
+#include "Benchmarks.h"
+#include "WriteAheadLog.h"
+#include <unistd.h>
+
+namespace {
+
+const int numOfCommands = 1000;
+const size_t defaultSyncCount = 64;  // main.cpp's --wal-sync-count
+const int defaultSyncInterval = 10; // main.cpp's --wal-sync-interval, in milliseconds
+
+// The configuration's plans stepping one step at a time, now and then changing their policies
+vector<string> makeCommands() {
+    const vector<string> policies = {"nve", "bal", "eco", "sus"};
+    vector<string> commands;
+    for (int i = 0; i < numOfCommands; i++) {
+        commands.push_back(i % 10 == 9 ? "changePolicy " + to_string(i / 10 % 2) + " " + policies[i / 20 % policies.size()] : "step 1");
+    }
+    return commands;
+}
+
+}
+
+// What writing the commands ahead costs: 1000 state-changing commands entered through the prompt, without a
+// write-ahead log, with one synced in batches as main.cpp syncs it by default, and with one synced before every command
+// (--wal-sync-count 1 --wal-sync-interval 0). For each: the time per command and the syncs made.
+void benchWal() {
+    char directory[] = "/tmp/simulation-bench-XXXXXX";
+    if (::mkdtemp(directory) == nullptr) {
+        throw runtime_error("Unable to make a temporary directory");
+    }
+    string path = string(directory) + "/commands.wal";
+    vector<string> commands = makeCommands();
+    const vector<pair<string, pair<size_t, int>>> modes = {
+        {"none", {0, 0}}, {"batched", {defaultSyncCount, defaultSyncInterval}}, {"synchronous", {1, 0}}};
+    printRow({"wal", "per command", "syncs"});
+    for (const pair<string, pair<size_t, int>> &mode : modes) {
+        bool isLogged = mode.second.first > 0;
+        Simulation *simulation = nullptr;
+        size_t numOfSyncs = 0;
+        size_t numOfRuns = 0;
+        double runTime = timeRuns([&]() { runCommands(*simulation, commands); }, [&]() {
+            if (simulation && simulation->getWriteAheadLog()) {
+                numOfSyncs += simulation->getWriteAheadLog()->getNumOfSyncs();
+                numOfRuns++;
+            }
+            delete simulation;
+            simulation = new Simulation(configurationPath);
+            if (isLogged) {
+                ::unlink(path.c_str());
+                simulation->openWriteAheadLog(path, mode.second.first, mode.second.second);
+            }
+        });
+        if (simulation->getWriteAheadLog()) {
+            numOfSyncs += simulation->getWriteAheadLog()->getNumOfSyncs();
+            numOfRuns++;
+        }
+        delete simulation;
+        printRow({mode.first, formatTime(runTime / numOfCommands), isLogged ? to_string(numOfSyncs / numOfRuns) : "-"});
+    }
+    ::unlink(path.c_str());
+    ::rmdir(directory);
+}
@@ -5,8 +5,12 @@
 #include "Facility.h"
 #include "SelectionPolicy.h"
 #include "Plan.h"
+#include "SimulationImage.h"
 
+#include <cstdint>
+#include <iomanip>
 #include <iostream>
+#include <memory>
 #include <sstream>
 #include <stdexcept>
 #include <string>
@@ -21,7 +25,28 @@ enum class ActionStatus{
     COMPLETED, ERROR
 };
 
-extern Simulation *backup;
+// The kinds of actions, one per command. Images record them by value, so the values never change.
+enum class ActionType {
+    STEP = 0,
+    PLAN = 1,
+    SETTLEMENT = 2,
+    FACILITY = 3,
+    PLAN_STATUS = 4,
+    CHANGE_POLICY = 5,
+    COMPARE = 6,
+    LOG = 7,
+    STATS = 8,
+    CLOSE = 9,
+    BACKUP = 10,
+    RESTORE = 11,
+    SNAPSHOTS = 12,
+    DROP_SNAPSHOT = 13,
+    SAVE = 14,
+    LOAD = 15,
+    UNDO = 16,
+};
+
+extern SimulationSnapshot *backup;
 
 class BaseAction{
     public:
@@ -30,14 +55,27 @@ class BaseAction{
         virtual void act(Simulation& simulation)=0;
         virtual const string toString() const=0;
         virtual BaseAction* clone() const = 0;
+        virtual ActionType getType() const = 0;
         virtual ~BaseAction() = default;
+        void save(ImageWriter &writer) const;
+        static BaseAction *load(ImageReader &reader);
+        bool changesState() const;
+        bool writesAhead() const;
+        virtual void replay(Simulation &simulation) const;
 
     protected:
+        virtual void saveArguments(ImageWriter &writer) const;
+        virtual void saveAhead(ImageWriter &writer);
         void complete();
         void error(string errorMsg);
         const string &getErrorMsg() const;
 
     private:
+        friend class ActionLog; // Records the actions, and rebuilds them from their records
+        friend class WriteAheadLog; // The same, on disk
+        static BaseAction *loadArguments(const ActionType type, ImageReader &reader);
+        static BaseAction *loadAhead(const ActionType type, ImageReader &reader);
+
         string errorMsg;
         ActionStatus status;
 };
@@ -47,9 +85,12 @@ class SimulateStep : public BaseAction {
     public:
         SimulateStep(const int numOfSteps);
         void act(Simulation &simulation) override;
+        void replay(Simulation &simulation) const override;
         const string toString() const override;
+        ActionType getType() const override;
         SimulateStep *clone() const override;
     private:
+        void saveArguments(ImageWriter &writer) const override;
         const int numOfSteps;
 };
 
@@ -57,9 +98,12 @@ class AddPlan : public BaseAction {
     public:
         AddPlan(const string &settlementName, const string &selectionPolicy);
         void act(Simulation &simulation) override;
+        void replay(Simulation &simulation) const override;
         const string toString() const override;
+        ActionType getType() const override;
         AddPlan *clone() const override;
     private:
+        void saveArguments(ImageWriter &writer) const override;
         const string settlementName;
         const string selectionPolicy;
 };
@@ -69,9 +113,12 @@ class AddSettlement : public BaseAction {
     public:
         AddSettlement(const string &settlementName,SettlementType settlementType);
         void act(Simulation &simulation) override;
+        void replay(Simulation &simulation) const override;
         AddSettlement *clone() const override;
         const string toString() const override;
+        ActionType getType() const override;
     private:
+        void saveArguments(ImageWriter &writer) const override;
         const string settlementName;
         const SettlementType settlementType;
 };
@@ -82,9 +129,12 @@ class AddFacility : public BaseAction {
     public:
         AddFacility(const string &facilityName, const FacilityCategory facilityCategory, const int price, const int lifeQualityScore, const int economyScore, const int environmentScore);
         void act(Simulation &simulation) override;
+        void replay(Simulation &simulation) const override;
         AddFacility *clone() const override;
         const string toString() const override;
+        ActionType getType() const override;
     private:
+        void saveArguments(ImageWriter &writer) const override;
         const string facilityName;
         const FacilityCategory facilityCategory;
         const int price;
@@ -100,7 +150,9 @@ class PrintPlanStatus: public BaseAction {
         void act(Simulation &simulation) override;
         PrintPlanStatus *clone() const override;
         const string toString() const override;
+        ActionType getType() const override;
     private:
+        void saveArguments(ImageWriter &writer) const override;
         const int planId;
 };
 
@@ -109,20 +161,57 @@ class ChangePlanPolicy : public BaseAction {
     public:
         ChangePlanPolicy(const int planId, const string &newPolicy);
         void act(Simulation &simulation) override;
+        void replay(Simulation &simulation) const override;
         ChangePlanPolicy *clone() const override;
         const string toString() const override;
+        ActionType getType() const override;
     private:
+        void saveArguments(ImageWriter &writer) const override;
         const int planId;
         const string newPolicy;
 };
 
 
+class ComparePolicies : public BaseAction {
+    public:
+        ComparePolicies(const int planId, const int numOfSteps);
+        void act(Simulation &simulation) override;
+        ComparePolicies *clone() const override;
+        const string toString() const override;
+        ActionType getType() const override;
+    private:
+        void saveArguments(ImageWriter &writer) const override;
+        const int planId;
+        const int numOfSteps;
+};
+
+
+// Prints count of the logged actions from the from-th on, of the given types only (all of them if none is given)
+// and only the failed ones if errorsOnly.
 class PrintActionsLog : public BaseAction {
     public:
-        PrintActionsLog();
+        static const size_t allActions = SIZE_MAX; // A count without a limit
+        PrintActionsLog(const size_t from, const size_t count, const vector<ActionType> &types, const bool errorsOnly);
+        static ActionType parseType(const string &name);
         void act(Simulation &simulation) override;
         PrintActionsLog *clone() const override;
         const string toString() const override;
+        ActionType getType() const override;
+    private:
+        void saveArguments(ImageWriter &writer) const override;
+        const size_t from;
+        const size_t count;
+        const vector<ActionType> types;
+        const bool errorsOnly;
+};
+
+class PrintStats : public BaseAction {
+    public:
+        PrintStats();
+        void act(Simulation &simulation) override;
+        PrintStats *clone() const override;
+        const string toString() const override;
+        ActionType getType() const override;
     private:
 };
 
@@ -132,24 +221,100 @@ class Close : public BaseAction {
         void act(Simulation &simulation) override;
         Close *clone() const override;
         const string toString() const override;
+        ActionType getType() const override;
     private:
 };
 
 class BackupSimulation : public BaseAction {
     public:
         BackupSimulation();
+        BackupSimulation(const string &snapshotName);
         void act(Simulation &simulation) override;
         BackupSimulation *clone() const override;
         const string toString() const override;
+        ActionType getType() const override;
     private:
+        void saveArguments(ImageWriter &writer) const override;
+        const string snapshotName; // Empty for the backup
 };
 
 
 class RestoreSimulation : public BaseAction {
     public:
         RestoreSimulation();
+        RestoreSimulation(const string &snapshotName);
         void act(Simulation &simulation) override;
         RestoreSimulation *clone() const override;
         const string toString() const override;
+        ActionType getType() const override;
     private:
-};
\ No newline at end of file
+        void saveArguments(ImageWriter &writer) const override;
+        const string snapshotName; // Empty for the backup
+};
+
+
+class PrintSnapshots : public BaseAction {
+    public:
+        PrintSnapshots();
+        void act(Simulation &simulation) override;
+        PrintSnapshots *clone() const override;
+        const string toString() const override;
+        ActionType getType() const override;
+    private:
+};
+
+
+class DropSnapshot : public BaseAction {
+    public:
+        DropSnapshot(const string &snapshotName);
+        void act(Simulation &simulation) override;
+        DropSnapshot *clone() const override;
+        const string toString() const override;
+        ActionType getType() const override;
+    private:
+        void saveArguments(ImageWriter &writer) const override;
+        const string snapshotName;
+};
+
+class SaveSimulation : public BaseAction {
+    public:
+        SaveSimulation(const string &path);
+        void act(Simulation &simulation) override;
+        SaveSimulation *clone() const override;
+        const string toString() const override;
+        ActionType getType() const override;
+    private:
+        void saveArguments(ImageWriter &writer) const override;
+        const string path;
+};
+
+
+class LoadSimulation : public BaseAction {
+    public:
+        LoadSimulation(const string &path);
+        void act(Simulation &simulation) override;
+        LoadSimulation *clone() const override;
+        const string toString() const override;
+        ActionType getType() const override;
+    private:
+        friend class BaseAction; // Rebuilds it from its write-ahead record
+        void saveArguments(ImageWriter &writer) const override;
+        void saveAhead(ImageWriter &writer) override;
+        static LoadSimulation *loadAhead(ImageReader &reader);
+        const string path;
+        shared_ptr<const vector<unsigned char>> image; // The image as the write-ahead record holds it, loaded instead of the file
+        string imageError; // Why the image couldn't be read for the record
+};
+
+
+class Undo : public BaseAction {
+    public:
+        Undo(const int numOfCommands);
+        void act(Simulation &simulation) override;
+        Undo *clone() const override;
+        const string toString() const override;
+        ActionType getType() const override;
+    private:
+        void saveArguments(ImageWriter &writer) const override;
+        const int numOfCommands;
+};
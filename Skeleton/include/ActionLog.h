@@ -0,0 +1,89 @@
+#pragma once
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using std::string;
+using std::vector;
+
+class BaseAction;
+enum class ActionType;
+
+// Strings kept once each and referred to by number, for records that repeat the same few names over and over.
+// A pool only grows, so a number stays valid in every log that shares the pool.
+class StringPool {
+    public:
+        StringPool();
+        size_t intern(const string &value);
+        const string &get(const size_t id) const;
+        size_t size() const;
+        size_t getMemoryUsage() const;
+
+    private:
+        unordered_map<string, size_t> ids;
+        vector<const string*> strings; // The keys of ids, by number
+};
+
+
+// The actions a simulation took, in order, as compact binary records in an append-only arena of fixed-size blocks.
+// A record is a tag (the action's type and whether it failed), the interned error message of a failed action,
+// then the action's arguments as images write them, with every string interned in a pool all the copies share.
+// Copies share the arena and each holds a prefix of it: copying is O(1), and a copy appends in place as long
+// as no other copy appended after it. Otherwise it first takes an arena of its own, sharing every block but its last.
+// Actions are only rebuilt to be read, one at a time, so reading a log of any length takes the memory of one action.
+// The arena also indexes the positions of the records by type and status, shared by the copies the same way,
+// so reading only the records of some types or only the failed ones takes time in the number read.
+class ActionLog {
+    public:
+        ActionLog();
+        size_t size() const;
+        bool empty() const;
+        void append(const BaseAction &action);
+        void clear();
+        void visit(const size_t begin, const size_t end, const function<void(const BaseAction&)> &visit) const;
+        void visit(const vector<ActionType> &types, const bool errorsOnly, const size_t from, const size_t count,
+                   const function<void(const BaseAction&)> &visit) const;
+        void measure(const bool isUnique, size_t &uniqueBytes, size_t &totalBytes) const;
+        void measureDifference(const ActionLog &other, size_t &bytes) const;
+
+    private:
+        static const size_t blockSize = 4096;
+        struct Block {
+            Block(const size_t firstRecord) : firstRecord(firstRecord), size(0), bytes() {}
+            size_t firstRecord; // Records never span two blocks
+            size_t size; // Bytes used, only growing while the block is the last of its arena
+            unsigned char bytes[blockSize];
+        };
+        static const size_t indexChunkSize = 128;
+        struct IndexChunk {
+            IndexChunk() : positions() {}
+            size_t positions[indexChunkSize];
+        };
+        struct Index {
+            Index() : chunks(), size(0) {}
+            vector<shared_ptr<IndexChunk>> chunks;
+            size_t size; // Of the longest copy, which has the positions past the end of the others
+        };
+        struct Arena {
+            Arena(const size_t numOfRecords);
+            vector<shared_ptr<Block>> blocks;
+            vector<Index> indexes; // The positions of the records (block * blockSize + offset), by tag
+            size_t numOfRecords; // Of the longest copy, the only one that appends in place
+        };
+        void branch();
+        size_t findBlock(const size_t record) const;
+        size_t endPosition() const;
+        size_t lowerBound(const Index &index, const size_t size, const size_t position) const;
+        size_t countIndexed(const Index &index) const;
+        BaseAction *decode(const size_t block, size_t &offset) const;
+        void visitAt(const size_t position, const function<void(const BaseAction&)> &visit) const;
+
+        shared_ptr<Arena> arena; // Null until the first record
+        size_t numOfRecords;
+        size_t numOfBlocks;
+        size_t lastBlockSize;
+        shared_ptr<StringPool> strings;
+};
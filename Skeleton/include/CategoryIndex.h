@@ -0,0 +1,24 @@
+#pragma once
+#include "Facility.h"
+#include <vector>
+
+using namespace std;
+using std::vector;
+
+// The catalog positions of each category's facility types, in catalog order, so round-robin policies
+// find the next type of their category without going over the types of the other categories.
+// Kept in sync with the simulation's catalog as types are added.
+class CategoryIndex {
+    public:
+        CategoryIndex();
+        void add(const FacilityType &type);
+        void rebuild(const vector<FacilityType> &facilityOptions);
+        bool isBuiltFor(const vector<FacilityType> &facilityOptions) const;
+        bool hasCategory(const FacilityCategory category) const;
+        int findNext(const FacilityCategory category, const int lastSelectedIndex, size_t &position) const;
+
+    private:
+        static const int numOfCategories = 3;
+        vector<int> positions[numOfCategories]; // Per FacilityCategory, ascending
+        size_t numOfTypes;
+};
@@ -1,4 +1,5 @@
 #pragma once
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -6,6 +7,7 @@ using std::string;
 using std::vector;
 using namespace std;
 
+class Settlement;
 
 enum class FacilityStatus {
     UNDER_CONSTRUCTIONS,
@@ -28,6 +30,7 @@ class FacilityType {
         int getEnvironmentScore() const;
         int getEconomyScore() const;
         FacilityCategory getCategory() const;
+        bool operator==(const FacilityType &other) const;
 
     protected:
         const string name;
@@ -40,20 +43,109 @@ class FacilityType {
 
 
 
-class Facility: public FacilityType {
+// A facility being built or already built in a plan.
+// Kept small since plans hold millions of them: the name and scores are looked up in the
+// shared facility catalog by index, and the settlement is the one of the owning plan.
+class Facility {
 
     public:
-        Facility(const string &name, const string &settlementName, const FacilityCategory category, const int price, const int lifeQuality_score, const int economy_score, const int environment_score);
-        Facility(const FacilityType &type, const string &settlementName);
+        Facility(const vector<FacilityType> &facilityOptions, const int typeIndex, const Settlement &settlement);
+        const FacilityType &getType() const;
+        int getTypeIndex() const;
+        const string &getName() const;
+        int getCost() const;
+        int getLifeQualityScore() const;
+        int getEnvironmentScore() const;
+        int getEconomyScore() const;
+        FacilityCategory getCategory() const;
         const string &getSettlementName() const;
         const int getTimeLeft() const;
         const FacilityStatus& getStatus() const;
         void setStatus(FacilityStatus status);
         FacilityStatus step();
+        FacilityStatus step(const int numOfSteps);
         const string toString() const;
 
     private:
-        const string settlementName;
-        FacilityStatus status;
+        const vector<FacilityType> *facilityOptions;
+        const Settlement *settlement;
+        int typeIndex;
         int timeLeft;
-};
\ No newline at end of file
+        FacilityStatus status;
+};
+
+
+
+// Hands out Facility objects from chunks instead of allocating each one on the heap.
+// A released facility's slot is reused by the next one, and all of them go away together with the pool's chunks.
+// A plan's pool has chunks of the plan's capacity: a plan never holds more facilities under construction, so it
+// takes a single chunk for its whole life, however many facilities it builds, and so does each copy of it.
+class FacilityPool {
+
+    public:
+        explicit FacilityPool(const size_t chunkSize);
+        FacilityPool(const FacilityPool &other) = delete;
+        FacilityPool &operator=(const FacilityPool &other) = delete;
+        FacilityPool(FacilityPool &&other) noexcept;
+        FacilityPool &operator=(FacilityPool &&other) = delete;
+        ~FacilityPool();
+        Facility *create(const vector<FacilityType> &facilityOptions, const int typeIndex, const Settlement &settlement);
+        Facility *create(const Facility &other);
+        void release(Facility *facility);
+        void clear();
+        size_t size() const;
+        size_t getMemoryUsage() const;
+        static size_t getNumOfCreatedFacilities();
+        static size_t getNumOfChunkAllocations();
+
+    private:
+        Facility *allocate();
+
+        const size_t chunkSize; // Facilities in each chunk
+        vector<Facility*> chunks; // Raw storage for chunkSize facilities each
+        vector<Facility*> freeSlots;
+        size_t numOfFacilities; // Slots handed out so far, including released ones
+        static atomic<size_t> createdFacilities; // Over all pools, for allocation statistics
+        static atomic<size_t> chunkAllocations;
+};
+
+
+// The facilities under construction of a plan, in construction order.
+// A doubly-linked list threaded through an array of slots: removing any facility is O(1) and keeps
+// the others in order, and removed slots are reused, so the array never grows past the plan's capacity.
+class ConstructionQueue {
+
+    public:
+        class const_iterator {
+            public:
+                const_iterator(const ConstructionQueue &queue, int slot);
+                Facility *operator*() const;
+                const_iterator &operator++();
+                bool operator!=(const const_iterator &other) const;
+            private:
+                const ConstructionQueue *queue;
+                int slot;
+        };
+
+        ConstructionQueue();
+        int push_back(Facility *facility);
+        void erase(const int slot);
+        Facility *at(const int slot) const;
+        int first() const;
+        int next(const int slot) const;
+        size_t size() const;
+        bool empty() const;
+        void clear();
+        const_iterator begin() const;
+        const_iterator end() const;
+
+    private:
+        struct Node {
+            Facility *facility;
+            int prev, next; // Neighbouring slots in construction order, or the next free slot; -1 for none
+        };
+        vector<Node> nodes;
+        int head, tail;
+        int freeSlot;
+        size_t numOfFacilities;
+};
@@ -2,19 +2,34 @@
 #include "Facility.h"
 #include "Settlement.h"
 #include "SelectionPolicy.h"
+#include "SharedVector.h"
+#include "SimulationImage.h"
 #include <sstream>
 #include <iostream>
 #include <algorithm>
 #include <vector>
+#include <deque>
+#include <map>
 
 using namespace std;
 using std::vector;
+using std::deque;
 
 enum class PlanStatus {
     AVALIABLE,
     BUSY,
 };
 
+// The concrete type of a plan's selection policy, so the plans of each type can be stepped together
+enum class PolicyType {
+    NAIVE,
+    BALANCED,
+    ECONOMY,
+    SUSTAINABILITY,
+    OPTIMAL,
+    OTHER, // Any other policy, stepped through its virtual functions
+};
+
 class Plan {
     public:
         Plan(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions);
@@ -29,21 +44,66 @@ class Plan {
         const int getEconomyScore() const;
         const int getEnvironmentScore() const;
         SelectionPolicy* getSelectionPolicy() const; 
-        const vector<Facility*> &getFacilities() const;
-        const vector<Facility *> &getFacilitiesUnderConstruction() const;
+        PolicyType getPolicyType() const;
+        const SharedVector<Facility> &getFacilities() const;
+        const ConstructionQueue &getFacilitiesUnderConstruction() const;
+        const vector<long long> &getOperationalCounts() const;
+        bool isCompact() const;
+        void setCompact(const bool compact);
         void setSelectionPolicy(SelectionPolicy *selectionPolicy);
+        size_t getCapacity() const;
+        static size_t getCapacity(const SettlementType settlementType);
+        void setState(const int lifeQualityScore, const int economyScore, const int environmentScore,
+                      const int *buildingTypes, const int *buildingTimers, const int numOfBuilding,
+                      const vector<int> &completedTypes);
+        bool canStep() const;
         void step();
+        void step(const int numOfSteps, const bool fastForward);
+        template <class Policy>
+        void stepAs(const int numOfSteps, const bool fastForward);
         void addFacility(Facility* facility);
         void printStatus();
         const string toString() const;
+        void measure(const bool isUnique, size_t &uniqueBytes, size_t &totalBytes) const;
+        void measureDifference(const Plan *other, size_t &bytes) const;
+        void save(ImageWriter &writer) const;
+        void load(ImageReader &reader);
 
     private:
+        // A facility under construction and the step on which it becomes operational
+        struct Completion {
+            long long step;
+            size_t order; // Position in underConstruction, breaks ties between same-step completions
+            long long startStep;
+            Facility *facility;
+            int slot; // In underConstruction
+        };
+        // Where a plan stood on some step, to measure what one cycle adds
+        struct CycleMark {
+            long long step;
+            int lifeQualityScore, economyScore, environmentScore;
+            size_t numOfCompletions;
+        };
+        static const size_t maxCycleStates = 1 << 16;
+        template <class Policy>
+        void stepWith(Policy &policy, const int numOfSteps, const bool fastForward);
+        static bool isLater(const Completion &a, const Completion &b);
+        vector<long long> getCycleState(const vector<Completion> &completions, const long long now) const;
+        void repeatCycle(const CycleMark &start, const long long numOfCycles, const long long skippedSteps,
+                         const vector<int> &completedTypes, vector<Completion> &completions);
+        void completeFacility(Facility *facility);
+        static PolicyType getPolicyType(const SelectionPolicy *selectionPolicy);
+
         int plan_id;
         const Settlement &settlement;
         SelectionPolicy *selectionPolicy; //What happens if we change this to a reference?
+        PolicyType policyType; // Of selectionPolicy, found once whenever it is set
         PlanStatus status;
-        vector<Facility*> facilities;
-        vector<Facility*> underConstruction;
+        FacilityPool facilityPool; // Owns the facilities under construction
+        SharedVector<Facility> facilities; // Operational, they never change, so copies of the plan share them
+        ConstructionQueue underConstruction;
+        bool compact; // Operational facilities are only counted per type, in operationalCounts
+        vector<long long> operationalCounts;
         const vector<FacilityType> &facilityOptions;
         int life_quality_score, economy_score, environment_score;
 };
\ No newline at end of file
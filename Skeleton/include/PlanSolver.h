@@ -0,0 +1,80 @@
+#pragma once
+#include "Facility.h"
+#include "ThreadPool.h"
+#include <array>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using std::vector;
+
+// Plans the constructions of OptimalSelection: the facility sequence that maximizes an objective of the
+// plan's scores (the smallest of the three, or their weighted sum) over the next horizon steps.
+// A plan refills each slot on the step it frees up and a facility takes its price in steps to build,
+// so the slots are independent timelines and only their summed scores matter. What one slot can add is
+// found once per number of steps left (the memo), keeping only the outcomes no other beats on every score;
+// one outcome per slot is then picked with branch and bound, dropping a branch when even the best outcome
+// of each remaining slot along some weighting of the scores couldn't beat the best pick found so far.
+// Ties on the objective of the completed scores go to the pick that committed more (scores under construction).
+// The first slot's outcomes are split into a fixed number of parts, searched on a thread pool when there is one,
+// so the chosen sequence doesn't depend on the number of threads.
+class PlanSolver {
+    public:
+        enum class Objective {
+            MIN_SCORE,    // The smallest of the three scores
+            WEIGHTED_SUM, // Of the three scores, with the weights given to setObjective
+        };
+        // A facility under construction (timeLeft 0 is one that never completes)
+        struct Construction {
+            int typeIndex;
+            int timeLeft;
+        };
+        // Where a plan stands at the start of a step, before it fills its free slots
+        struct State {
+            State();
+            int lifeQualityScore, economyScore, environmentScore; // Of the operational facilities
+            vector<Construction> building;
+        };
+
+        PlanSolver();
+        PlanSolver(const PlanSolver &other); // Takes the settings only
+        PlanSolver &operator=(const PlanSolver &other) = delete;
+        ~PlanSolver();
+        void setHorizon(const int horizon);
+        int getHorizon() const;
+        void setObjective(const Objective objective, const int lifeQualityWeight, const int economyWeight, const int environmentWeight);
+        void setNumOfThreads(const int numOfThreads);
+        void solve(const vector<FacilityType> &facilityOptions, const size_t capacity, State &state, deque<int> &selections) const;
+        size_t getNumOfSolves() const;
+        size_t getNumOfNodes() const;
+        size_t getNumOfMemoHits() const;
+        size_t getSolveMicroseconds() const;
+
+    private:
+        // (objective of the scores completed within the horizon, objective of all the scores committed to)
+        typedef pair<long long, long long> Value;
+        struct Problem;
+        class Search;
+
+        static const size_t maxCandidates = 24; // Larger catalogs are cut down to their most score-efficient types
+        static const size_t maxNodes = 1 << 20; // Per solve, shared out between its parts
+        static const size_t maxFrontierSize = 1024; // Outcomes kept per number of steps left, best first
+        static const size_t numOfParts = 16; // Independent searches per solve
+        static const int numOfDirectionSteps = 6; // Of the weight grid that bounds the smallest score
+        static int getImpact(const FacilityType &type, const int score);
+        Problem makeProblem(const vector<FacilityType> &facilityOptions, const size_t capacity) const;
+        long long evaluate(const long long scores[3]) const;
+
+        int horizon;
+        Objective objective;
+        int weights[3];
+        int numOfThreads;
+        mutable ThreadPool *workers; // Created on the first parallel solve, one solve at a time uses it
+        mutable mutex workersLock;
+        mutable atomic<size_t> numOfSolves, numOfNodes, numOfMemoHits, solveMicroseconds;
+};
@@ -0,0 +1,38 @@
+#pragma once
+#include "Facility.h"
+#include "Plan.h"
+#include <vector>
+
+using namespace std;
+using std::vector;
+
+// An alternative stepping core: the hot state of many plans (capacity, scores and the timers of the
+// facilities under construction) is loaded into parallel arrays, stepped tick by tick with a linear
+// sweep over them, and stored back into the plans. Selections still go through each plan's policy.
+class PlanStateEngine {
+    public:
+        PlanStateEngine(const vector<FacilityType> &facilityOptions);
+        void load(Plan &plan);
+        size_t size() const;
+        void step(const int numOfSteps, const size_t begin, const size_t end);
+        void store();
+
+    private:
+        const vector<FacilityType> &facilityOptions;
+
+        // Catalog columns
+        vector<int> prices;
+        vector<int> lifeQualityImpacts, economyImpacts, environmentImpacts;
+
+        // Plan columns
+        vector<Plan*> plans; // Held from load to store only, no snapshot of them is taken in between
+        vector<int> capacities;
+        vector<int> lifeQualityScores, economyScores, environmentScores;
+        vector<int> numOfBuilding;
+        vector<size_t> firstSlot; // Each plan owns capacity consecutive slots, in construction order
+        vector<vector<int>> completedTypes; // Per plan, in completion order
+
+        // Slot columns
+        vector<int> slotTypes;
+        vector<int> slotTimers;
+};
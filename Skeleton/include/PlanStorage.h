@@ -0,0 +1,58 @@
+#pragma once
+#include "Plan.h"
+#include "SharedVector.h"
+#include <vector>
+
+using namespace std;
+using std::vector;
+
+// Holds the simulation's plans in fixed-size chunks, so growing costs one chunk allocation per chunkSize plans.
+// Copies share the chunks (see SharedVector): copying is O(1), and a chunk of plans is copied the first time
+// one of the storages sharing it hands out a plan in it for changing. Read-only access never copies.
+// So a Plan& handed out for changing is only good until the storage is next copied, assigned or cleared: after a copy
+// it refers to a plan the copy shares, which a later change (or an added plan) moves to a chunk of this storage's own.
+// Get the plan again after any of these instead of holding on to it.
+class PlanStorage {
+    public:
+        class iterator {
+            public:
+                iterator(PlanStorage &storage, size_t index);
+                Plan &operator*() const;
+                iterator &operator++();
+                bool operator!=(const iterator &other) const;
+            private:
+                PlanStorage *storage;
+                size_t index;
+        };
+
+        class const_iterator {
+            public:
+                const_iterator(const PlanStorage &storage, size_t index);
+                const Plan &operator*() const;
+                const_iterator &operator++();
+                bool operator!=(const const_iterator &other) const;
+            private:
+                const PlanStorage *storage;
+                size_t index;
+        };
+
+        PlanStorage();
+        Plan &add(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions);
+        Plan &add(const Plan &other);
+        Plan &operator[](size_t index);
+        const Plan &operator[](size_t index) const;
+        Plan &back();
+        size_t size() const;
+        void clear();
+        void unshare();
+        void measure(size_t &uniqueBytes, size_t &totalBytes) const;
+        void measureDifference(const PlanStorage &other, size_t &bytes) const;
+        iterator begin();
+        iterator end();
+        const_iterator begin() const;
+        const_iterator end() const;
+
+    private:
+        static const size_t chunkSize = 64;
+        SharedVector<Plan, chunkSize> plans;
+};
@@ -0,0 +1,92 @@
+#pragma once
+#include "Facility.h"
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+using std::vector;
+
+// Answers BalancedSelection's question - which facility type leaves the smallest range between the
+// three scores once added to the given ones - without scanning the whole catalog.
+// Only score differences matter: a type (l, e, n) added to (L, E, N) has range max(|u|, |v|, |u + v|)
+// with u = (l - e) - (E - L) and v = (e - n) - (N - E), so the answer is the nearest point to (E - L, N - E)
+// among the types' (l - e, e - n) under that distance. The points are kept in a 2-d tree.
+// Catalogs too small for the tree to pay off are scanned instead, over int columns of the scores,
+// with the widest vector instructions the CPU has (see ScoreIndex.cpp).
+// Balanced plans keep coming back to the same differences, so recent answers are remembered per
+// difference vector, for as long as the catalog stays the same.
+class ScoreIndex {
+    public:
+        // How answers are found. AUTOMATIC is what the simulation uses: the tree for large catalogs, otherwise
+        // the widest scan the CPU runs. The others force one way for any catalog, to check and time them against each other.
+        enum class Method {
+            AUTOMATIC,
+            SCAN_SCALAR,
+            SCAN_SSE41,
+            SCAN_AVX2,
+            TREE,
+        };
+
+        ScoreIndex();
+        ScoreIndex(const ScoreIndex &other) = delete;
+        ScoreIndex &operator=(const ScoreIndex &other) = delete;
+        static bool isSupported(const Method method);
+        void update(const vector<FacilityType> &facilityOptions, const Method method = Method::AUTOMATIC);
+        void clear();
+        bool isBuiltFor(const vector<FacilityType> &facilityOptions) const;
+        int findMostBalanced(const int lifeQualityScore, const int economyScore, const int environmentScore) const;
+        size_t getNumOfCacheHits() const;
+        size_t getNumOfCacheMisses() const;
+
+    private:
+        struct Point {
+            long long x, y;
+            int index; // In the catalog
+        };
+        // Of the subtree rooted at some position: the box around its points and their first catalog index
+        struct Bounds {
+            long long minX, maxX, minY, maxY;
+            int minIndex;
+        };
+        // (E - L, N - E) of the scores a decision was made for
+        typedef pair<long long, long long> Differences;
+        struct DifferencesHash {
+            size_t operator()(const Differences &differences) const;
+        };
+        // Least recently used decisions are dropped first. Plans on different threads mostly
+        // hit different shards, so they rarely wait for each other.
+        struct DecisionShard {
+            DecisionShard();
+            mutex lock;
+            list<pair<Differences, int>> decisions; // Most recently used first
+            unordered_map<Differences, list<pair<Differences, int>>::iterator, DifferencesHash> positions;
+        };
+
+        static const size_t minIndexedSize = 2048; // Smaller catalogs are faster to scan with vector instructions
+        static const size_t minCachedSize = 64; // Smaller catalogs are scanned faster than looked up
+        static const size_t numOfDecisionShards = 16;
+        static const size_t maxDecisionsPerShard = 1 << 12;
+        static int scan(const Method method, const int *lifeQualityImpacts, const int *economyImpacts, const int *environmentImpacts, const size_t size,
+                        const int lifeQualityScore, const int economyScore, const int environmentScore);
+        int computeMostBalanced(const int lifeQualityScore, const int economyScore, const int environmentScore) const;
+        void clearDecisions();
+        static long long distanceToZero(const long long low, const long long high);
+        void build(const size_t begin, const size_t end, const bool splitOnX);
+        void search(const size_t begin, const size_t end, const bool splitOnX, const long long queryX, const long long queryY,
+                    long long &bestRange, int &bestIndex) const;
+
+        const FacilityType *catalog; // The catalog the tree was built for, compared by address and size
+        size_t catalogSize;
+        Method method; // Of the last update
+        // The catalog's scores, column by column
+        vector<int> lifeQualityImpacts, economyImpacts, environmentImpacts;
+        // The tree over [begin, end) is rooted at its middle position, with the two halves as subtrees
+        vector<Point> points;
+        vector<Bounds> bounds;
+        // Remembered decisions, for the catalog as of the last update
+        mutable DecisionShard decisionShards[numOfDecisionShards];
+        mutable atomic<size_t> cacheHits, cacheMisses;
+};
@@ -1,8 +1,13 @@
 #pragma once
 #include <vector>
 #include "Facility.h"
+#include "ScoreIndex.h"
+#include "CategoryIndex.h"
+#include "PlanSolver.h"
+#include "SimulationImage.h"
 #include <algorithm>
 #include <climits>
+#include <deque>
 #include <stdexcept> 
 #include <iostream>
 #include <fstream>
@@ -13,53 +18,129 @@ using std::vector;
 class SelectionPolicy {
     public:
         virtual const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) = 0;
+        virtual void selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) = 0;
+        virtual bool canSelect(const vector<FacilityType>& facilitiesOptions) const = 0;
+        virtual bool isRoundRobin() const = 0; // Whole state is the last selected index, so the choices repeat
+        virtual int getLastSelectedIndex() const = 0;
         virtual const string toString() const = 0;
         virtual SelectionPolicy* clone() const = 0;
+        virtual void save(ImageWriter &writer) const = 0; // The policy's state, its type is its name (toString)
+        virtual void load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) = 0; // Checks the state against the catalog
         virtual ~SelectionPolicy() = default;
 };
 
-class NaiveSelection: public SelectionPolicy {
+class NaiveSelection final: public SelectionPolicy {
     public:
         NaiveSelection();
         const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        void selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) override;
+        bool canSelect(const vector<FacilityType>& facilitiesOptions) const override;
+        bool isRoundRobin() const override;
+        int getLastSelectedIndex() const override;
         const string toString() const override;
         NaiveSelection *clone() const override;
+        void save(ImageWriter &writer) const override;
+        void load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) override;
         ~NaiveSelection() override = default;
     private:
+        int selectIndex(const vector<FacilityType>& facilitiesOptions);
         int lastSelectedIndex;
 };
 
-class BalancedSelection: public SelectionPolicy {
+class BalancedSelection final: public SelectionPolicy {
     public:
-        BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore);
+        BalancedSelection(int LifeQualityScore, int EconomyScore, int EnvironmentScore, const ScoreIndex *scoreIndex = nullptr);
+        BalancedSelection(const BalancedSelection &other) = default; // Copies share the index
+        BalancedSelection &operator=(const BalancedSelection &other) = default;
         const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        void selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) override;
+        bool canSelect(const vector<FacilityType>& facilitiesOptions) const override;
+        bool isRoundRobin() const override;
+        int getLastSelectedIndex() const override;
         const string toString() const override;
         BalancedSelection *clone() const override;
+        void save(ImageWriter &writer) const override;
+        void load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) override;
+        void setScoreIndex(const ScoreIndex *scoreIndex);
     private:
+        int selectIndex(const vector<FacilityType>& facilitiesOptions);
         int LifeQualityScore;
         int EconomyScore;
         int EnvironmentScore;
+        const ScoreIndex *scoreIndex; // Shared with the simulation's other plans, may be null
 };
 
-class EconomySelection: public SelectionPolicy {
+class EconomySelection final: public SelectionPolicy {
     public:
-        EconomySelection();
+        EconomySelection(const CategoryIndex *categoryIndex = nullptr);
+        EconomySelection(const EconomySelection &other) = default; // Copies share the index
+        EconomySelection &operator=(const EconomySelection &other) = default;
         const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        void selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) override;
+        bool canSelect(const vector<FacilityType>& facilitiesOptions) const override;
+        bool isRoundRobin() const override;
+        int getLastSelectedIndex() const override;
         const string toString() const override;
         EconomySelection *clone() const override;
+        void save(ImageWriter &writer) const override;
+        void load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) override;
         ~EconomySelection() override = default;
+        void setCategoryIndex(const CategoryIndex *categoryIndex);
     private:
+        int selectIndex(const vector<FacilityType>& facilitiesOptions);
         int lastSelectedIndex;
+        size_t lastSelectedPosition; // Of lastSelectedIndex among the category's types, a hint for the index
+        const CategoryIndex *categoryIndex; // Shared with the simulation's other plans, may be null
 
 };
 
-class SustainabilitySelection: public SelectionPolicy {
+class SustainabilitySelection final: public SelectionPolicy {
     public:
-        SustainabilitySelection();
+        SustainabilitySelection(const CategoryIndex *categoryIndex = nullptr);
+        SustainabilitySelection(const SustainabilitySelection &other) = default; // Copies share the index
+        SustainabilitySelection &operator=(const SustainabilitySelection &other) = default;
         const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        void selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) override;
+        bool canSelect(const vector<FacilityType>& facilitiesOptions) const override;
+        bool isRoundRobin() const override;
+        int getLastSelectedIndex() const override;
         const string toString() const override;
         SustainabilitySelection *clone() const override;
+        void save(ImageWriter &writer) const override;
+        void load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) override;
         ~SustainabilitySelection() override = default;
+        void setCategoryIndex(const CategoryIndex *categoryIndex);
     private:
+        int selectIndex(const vector<FacilityType>& facilitiesOptions);
         int lastSelectedIndex;
-};
\ No newline at end of file
+        size_t lastSelectedPosition; // Of lastSelectedIndex among the category's types, a hint for the index
+        const CategoryIndex *categoryIndex; // Shared with the simulation's other plans, may be null
+};
+
+// Builds what a PlanSolver found best for the next horizon, solving again once that is used up.
+// The policy follows the plan's schedule on its own (as BalancedSelection follows its scores),
+// starting from the plan's state when the policy is created.
+class OptimalSelection final: public SelectionPolicy {
+    public:
+        OptimalSelection(const size_t capacity, const PlanSolver *planSolver, const PlanSolver::State &state = PlanSolver::State());
+        OptimalSelection(const OptimalSelection &other) = default; // Copies share the solver
+        OptimalSelection &operator=(const OptimalSelection &other) = default;
+        const FacilityType& selectFacility(const vector<FacilityType>& facilitiesOptions) override;
+        void selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) override;
+        bool canSelect(const vector<FacilityType>& facilitiesOptions) const override;
+        bool isRoundRobin() const override;
+        int getLastSelectedIndex() const override;
+        const string toString() const override;
+        OptimalSelection *clone() const override;
+        void save(ImageWriter &writer) const override;
+        void load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) override;
+        ~OptimalSelection() override = default;
+        void setPlanSolver(const PlanSolver *planSolver);
+    private:
+        int selectIndex(const vector<FacilityType>& facilitiesOptions);
+        size_t capacity;
+        PlanSolver::State state; // Where the plan stands once the planned selections are built
+        deque<int> plannedSelections; // Catalog indices, in selection order
+        int lastSelectedIndex;
+        const PlanSolver *planSolver; // Shared with the simulation's other plans
+};
@@ -0,0 +1,287 @@
+#pragma once
+#include <memory>
+#include <utility>
+#include <vector>
+
+using namespace std;
+using std::vector;
+
+// A vector whose copies share their elements. The elements are kept in reference-counted chunks of chunkSize,
+// behind a reference-counted table of chunks, so copying the vector is O(1) and a chunk (or the table) is only
+// copied when one of the vectors sharing it changes it. Reading never copies anything.
+// Chunks never reallocate, so an element stays where it is for as long as its chunk isn't shared.
+// Changes aren't thread-safe: a vector that is changed from several threads (on distinct elements) is unshared first.
+template <class T, size_t chunkSize = 64>
+class SharedVector {
+    public:
+        class const_iterator {
+            public:
+                const_iterator(const SharedVector &elements, size_t index);
+                const T &operator*() const;
+                const_iterator &operator++();
+                bool operator!=(const const_iterator &other) const;
+            private:
+                const SharedVector *elements;
+                size_t index;
+        };
+
+        SharedVector();
+        SharedVector(const SharedVector &other) = default; // Shares other's chunks
+        SharedVector &operator=(const SharedVector &other) = default;
+        SharedVector(SharedVector &&other) noexcept;
+        SharedVector &operator=(SharedVector &&other) noexcept;
+        size_t size() const;
+        bool empty() const;
+        const T &operator[](const size_t index) const;
+        const T &back() const;
+        T &edit(const size_t index);
+        void push_back(const T &value);
+        template <class... Args>
+        void emplace_back(Args&&... args);
+        void pop_back();
+        void clear();
+        void unshare();
+        size_t countShared(const SharedVector &other) const;
+        template <class MeasureElement>
+        void measure(const bool isUnique, size_t &uniqueBytes, size_t &totalBytes, MeasureElement measureElement) const;
+        template <class MeasureElement>
+        void measureDifference(const SharedVector &other, size_t &bytes, MeasureElement measureElement) const;
+        const_iterator begin() const;
+        const_iterator end() const;
+
+    private:
+        typedef vector<T> Chunk;
+        typedef vector<shared_ptr<Chunk>> Table;
+        static shared_ptr<Chunk> copyChunk(const Chunk &chunk);
+        Table &editTable();
+        Chunk &editChunk(const size_t chunk);
+        Chunk &editLastChunk();
+
+        shared_ptr<Table> table; // Null until the first element
+        size_t numOfElements;
+};
+
+// Rule of 5 used here - Copies share the chunks, which are released by their last owner.
+
+// Constructor: empty, without a table yet
+template <class T, size_t chunkSize>
+SharedVector<T, chunkSize>::SharedVector() : table(), numOfElements(0) {}
+
+// Move Constructor: other is left empty
+template <class T, size_t chunkSize>
+SharedVector<T, chunkSize>::SharedVector(SharedVector &&other) noexcept : table(move(other.table)), numOfElements(other.numOfElements) {
+    other.numOfElements = 0;
+}
+
+// Move Assignment Operator
+template <class T, size_t chunkSize>
+SharedVector<T, chunkSize> &SharedVector<T, chunkSize>::operator=(SharedVector &&other) noexcept {
+    if (this == &other) return *this; // Handle self-assignment
+    table = move(other.table);
+    numOfElements = other.numOfElements;
+    other.table.reset();
+    other.numOfElements = 0;
+    return *this;
+}
+
+template <class T, size_t chunkSize>
+size_t SharedVector<T, chunkSize>::size() const {
+    return numOfElements;
+}
+
+template <class T, size_t chunkSize>
+bool SharedVector<T, chunkSize>::empty() const {
+    return numOfElements == 0;
+}
+
+// Read-only access by position
+template <class T, size_t chunkSize>
+const T &SharedVector<T, chunkSize>::operator[](const size_t index) const {
+    return (*(*table)[index / chunkSize])[index % chunkSize];
+}
+
+template <class T, size_t chunkSize>
+const T &SharedVector<T, chunkSize>::back() const {
+    return (*this)[numOfElements - 1];
+}
+
+// Access for changing an element, copying its chunk first if another vector shares it
+template <class T, size_t chunkSize>
+T &SharedVector<T, chunkSize>::edit(const size_t index) {
+    return editChunk(index / chunkSize)[index % chunkSize];
+}
+
+// Appends a copy of value, which may be an element of this vector
+template <class T, size_t chunkSize>
+void SharedVector<T, chunkSize>::push_back(const T &value) {
+    editLastChunk().push_back(value);
+    numOfElements++;
+}
+
+// Appends an element built in place
+template <class T, size_t chunkSize>
+template <class... Args>
+void SharedVector<T, chunkSize>::emplace_back(Args&&... args) {
+    editLastChunk().emplace_back(forward<Args>(args)...);
+    numOfElements++;
+}
+
+// Removes the last element
+template <class T, size_t chunkSize>
+void SharedVector<T, chunkSize>::pop_back() {
+    size_t chunk = (numOfElements - 1) / chunkSize;
+    if ((numOfElements - 1) % chunkSize == 0) {
+        editTable().pop_back();
+    } else {
+        editChunk(chunk).pop_back();
+    }
+    numOfElements--;
+}
+
+// Drops all the elements (the vectors sharing them keep theirs)
+template <class T, size_t chunkSize>
+void SharedVector<T, chunkSize>::clear() {
+    table.reset();
+    numOfElements = 0;
+}
+
+// Copies every chunk another vector shares, so that changes no longer copy anything
+template <class T, size_t chunkSize>
+void SharedVector<T, chunkSize>::unshare() {
+    if (numOfElements == 0) return;
+    for (size_t chunk = 0; chunk < table->size(); chunk++) {
+        editChunk(chunk);
+    }
+}
+
+// Number of leading elements this vector and other hold in the same chunks, i.e. certainly have in common
+template <class T, size_t chunkSize>
+size_t SharedVector<T, chunkSize>::countShared(const SharedVector &other) const {
+    if (table == other.table) {
+        return numOfElements;
+    }
+    if (numOfElements == 0 || other.numOfElements == 0) {
+        return 0;
+    }
+    size_t numOfShared = 0;
+    for (size_t chunk = 0; chunk < table->size() && chunk < other.table->size() && (*table)[chunk] == (*other.table)[chunk]; chunk++) {
+        numOfShared += (*table)[chunk]->size();
+    }
+    return numOfShared;
+}
+
+// Adds the bytes of this vector's table and chunks to totalBytes, and of those no other vector shares to uniqueBytes
+// (what dropping the vector would free). isUnique tells whether the vector itself is held by a single owner.
+// measureElement(element, isUnique, uniqueBytes, totalBytes) adds what an element holds outside of its chunk.
+template <class T, size_t chunkSize>
+template <class MeasureElement>
+void SharedVector<T, chunkSize>::measure(const bool isUnique, size_t &uniqueBytes, size_t &totalBytes, MeasureElement measureElement) const {
+    if (!table) return;
+    bool isTableUnique = isUnique && table.use_count() == 1;
+    size_t tableBytes = sizeof(Table) + table->capacity() * sizeof(shared_ptr<Chunk>);
+    totalBytes += tableBytes;
+    uniqueBytes += isTableUnique ? tableBytes : 0;
+    for (const shared_ptr<Chunk> &chunk : *table) {
+        bool isChunkUnique = isTableUnique && chunk.use_count() == 1;
+        size_t chunkBytes = sizeof(Chunk) + chunk->capacity() * sizeof(T);
+        totalBytes += chunkBytes;
+        uniqueBytes += isChunkUnique ? chunkBytes : 0;
+        for (const T &element : *chunk) {
+            measureElement(element, isChunkUnique, uniqueBytes, totalBytes);
+        }
+    }
+}
+
+// Adds the bytes of this vector's table and chunks that other doesn't share to bytes: what this vector holds on top of other.
+// Only the chunks that differ are visited. measureElement(element, otherElement, bytes) adds what an element of such a chunk
+// holds on top of the element at the same position in other (null if other is shorter).
+template <class T, size_t chunkSize>
+template <class MeasureElement>
+void SharedVector<T, chunkSize>::measureDifference(const SharedVector &other, size_t &bytes, MeasureElement measureElement) const {
+    if (!table || table == other.table) return;
+    bytes += sizeof(Table) + table->capacity() * sizeof(shared_ptr<Chunk>);
+    for (size_t chunk = 0; chunk < table->size(); chunk++) {
+        const Chunk &elements = *(*table)[chunk];
+        const Chunk *otherElements = (other.table && chunk < other.table->size()) ? (*other.table)[chunk].get() : nullptr;
+        if (&elements == otherElements) continue;
+        bytes += sizeof(Chunk) + elements.capacity() * sizeof(T);
+        for (size_t i = 0; i < elements.size(); i++) {
+            measureElement(elements[i], (otherElements != nullptr && i < otherElements->size()) ? &(*otherElements)[i] : nullptr, bytes);
+        }
+    }
+}
+
+// Iteration in order, read-only
+template <class T, size_t chunkSize>
+typename SharedVector<T, chunkSize>::const_iterator SharedVector<T, chunkSize>::begin() const {
+    return const_iterator(*this, 0);
+}
+
+template <class T, size_t chunkSize>
+typename SharedVector<T, chunkSize>::const_iterator SharedVector<T, chunkSize>::end() const {
+    return const_iterator(*this, numOfElements);
+}
+
+template <class T, size_t chunkSize>
+SharedVector<T, chunkSize>::const_iterator::const_iterator(const SharedVector &elements, size_t index) : elements(&elements), index(index) {}
+
+template <class T, size_t chunkSize>
+const T &SharedVector<T, chunkSize>::const_iterator::operator*() const {
+    return (*elements)[index];
+}
+
+template <class T, size_t chunkSize>
+typename SharedVector<T, chunkSize>::const_iterator &SharedVector<T, chunkSize>::const_iterator::operator++() {
+    index++;
+    return *this;
+}
+
+template <class T, size_t chunkSize>
+bool SharedVector<T, chunkSize>::const_iterator::operator!=(const const_iterator &other) const {
+    return index != other.index;
+}
+
+// A chunk of its own with the same elements, with room for chunkSize of them
+template <class T, size_t chunkSize>
+shared_ptr<typename SharedVector<T, chunkSize>::Chunk> SharedVector<T, chunkSize>::copyChunk(const Chunk &chunk) {
+    shared_ptr<Chunk> copy = make_shared<Chunk>();
+    copy->reserve(chunkSize);
+    for (const T &element : chunk) {
+        copy->push_back(element);
+    }
+    return copy;
+}
+
+// The table of chunks, copied first if another vector shares it (the chunks stay shared)
+template <class T, size_t chunkSize>
+typename SharedVector<T, chunkSize>::Table &SharedVector<T, chunkSize>::editTable() {
+    if (!table) {
+        table = make_shared<Table>();
+    } else if (table.use_count() != 1) {
+        table = make_shared<Table>(*table);
+    }
+    return *table;
+}
+
+// A chunk of this vector only
+template <class T, size_t chunkSize>
+typename SharedVector<T, chunkSize>::Chunk &SharedVector<T, chunkSize>::editChunk(const size_t chunk) {
+    shared_ptr<Chunk> &owned = editTable()[chunk];
+    if (owned.use_count() != 1) {
+        owned = copyChunk(*owned);
+    }
+    return *owned;
+}
+
+// The chunk the next element goes to, a new one if the last is full.
+// A chunk that is replaced by its copy stays alive in the vectors sharing it, so a value being appended from it stays valid.
+template <class T, size_t chunkSize>
+typename SharedVector<T, chunkSize>::Chunk &SharedVector<T, chunkSize>::editLastChunk() {
+    if (numOfElements % chunkSize == 0) {
+        Table &chunks = editTable();
+        chunks.push_back(make_shared<Chunk>());
+        chunks.back()->reserve(chunkSize);
+        return *chunks.back();
+    }
+    return editChunk(numOfElements / chunkSize);
+}
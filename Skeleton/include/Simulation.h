@@ -1,16 +1,31 @@
 #pragma once
 #include <string>
 #include <vector>
+#include "ActionLog.h"
 #include "Facility.h"
 #include "Plan.h"
+#include "PlanStorage.h"
+#include "PlanStateEngine.h"
+#include "ScoreIndex.h"
+#include "CategoryIndex.h"
+#include "PlanSolver.h"
 #include "SelectionPolicy.h"
 #include "Settlement.h"
+#include "SharedVector.h"
+#include "SimulationSnapshot.h"
+#include "SimulationImage.h"
+#include "UndoJournal.h"
+#include "WriteAheadLog.h"
 #include "Auxiliary.h"
+#include "ThreadPool.h"
 
 #include <algorithm>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
 #include <sstream>
+#include <unordered_map>
 
 using namespace std;
 using std::string;
@@ -18,12 +33,22 @@ using std::vector;
 
 class BaseAction;
 
+enum class StepCore {
+    PLANS,  // Each plan steps its own objects, skipping idle steps
+    ARRAYS, // A PlanStateEngine sweeps struct-of-arrays copies of all the plans
+};
+
+enum class BackupMode {
+    SNAPSHOTS, // Backups share the state with the simulation, and hold what changed since they were taken
+    REPLAY,    // Backups only share the log, and are rebuilt by replaying it from the last checkpoint
+};
+
 
 class Simulation {
     public:
         Simulation(const string &configFilePath);
-        Simulation(const Simulation &other);              
-        Simulation &operator=(const Simulation &other);   
+        Simulation(const Simulation &other) = delete; // Copies are taken as a SimulationSnapshot
+        Simulation &operator=(const Simulation &other) = delete;
         Simulation(Simulation &&other) noexcept;
         Simulation &operator=(Simulation &&other) noexcept;
         ~Simulation(); 
@@ -34,20 +59,82 @@ class Simulation {
         bool addFacility(FacilityType facility);
         bool isSettlementExists(const string &settlementName);
         bool isFacilityExists(const string &facilityName);
-        bool isPlanExists(const int planId);
+        bool isPlanExists(const int planId) const;
         Settlement &getSettlement(const string &settlementName);
         Plan &getPlan(const int planID);
-        const std::vector<BaseAction*>& getActionsLog() const;
+        const Plan &getPlan(const int planID) const;
+        const ScoreIndex *getScoreIndex() const;
+        const CategoryIndex *getCategoryIndex() const;
+        const PlanSolver *getPlanSolver() const;
+        const UndoJournal *getUndoJournal() const;
+        const WriteAheadLog *getWriteAheadLog() const;
+        SelectionPolicy *createSelectionPolicy(const Plan &plan, const string &policyName) const;
+        const ActionLog &getActionsLog() const;
+        void setNumOfThreads(const int numOfThreads);
+        int getNumOfThreads() const;
+        void setFastForward(const bool fastForward);
+        void setCompact(const bool compact);
+        void setStepCore(const StepCore stepCore);
+        void setSolverHorizon(const int horizon);
+        void setSolverObjective(const PlanSolver::Objective objective, const int lifeQualityWeight, const int economyWeight, const int environmentWeight);
+        void setUndoMemoryLimit(const size_t memoryLimit);
+        void setBackupMode(const BackupMode backupMode, const size_t checkpointInterval);
+        size_t openWriteAheadLog(const string &path, const size_t syncCount, const int syncInterval);
         void step();
+        void step(const int numOfSteps);
+        void stepForks(PlanStorage &forks, const int numOfSteps);
+        SimulationSnapshot *takeSnapshot();
+        void restore(const SimulationSnapshot &snapshot);
+        void undo(const int numOfCommands);
+        void save(const string &path) const;
+        void load(const string &path);
+        void load(const vector<unsigned char> &image);
+        void addSnapshot(const string &snapshotName);
+        bool isSnapshotExists(const string &snapshotName) const;
+        const SimulationSnapshot &getSnapshot(const string &snapshotName) const;
+        void dropSnapshot(const string &snapshotName);
+        const map<string, SimulationSnapshot*> &getSnapshots() const;
         void close();
         void open();
         
 
     private:
+        friend class SimulationSnapshot;
+        shared_ptr<const vector<FacilityType>> shareFacilitiesOptions();
+        void restoreFacilitiesOptions(const shared_ptr<const vector<FacilityType>> &restored);
+        void execute(BaseAction *action);
+        void load(ImageReader &reader);
+        void replay(const SimulationSnapshot &snapshot);
+        void groupPlans();
+        template <class Policy>
+        void stepGroup(const vector<size_t> &group, const int numOfSteps);
+        void runSlices(const size_t count, const function<void(size_t, size_t)> &slice);
+
         bool isRunning;
         int planCounter; 
-        vector<BaseAction*> actionsLog;
-        vector<Plan> plans;
-        vector<Settlement*> settlements;
-        vector<FacilityType> facilitiesOptions;
+        int numOfThreads;
+        bool fastForward;
+        bool compact;
+        StepCore stepCore;
+        BackupMode backupMode;
+        size_t checkpointInterval; // Actions between checkpoints in replay mode, 0 for none
+        ThreadPool *workers; // Created on the first parallel step, never copied
+        ScoreIndex *scoreIndex; // Of facilitiesOptions, for the balanced plans; updated before stepping
+        CategoryIndex *categoryIndex; // Of facilitiesOptions, for the eco and sus plans; kept in sync
+        PlanSolver *planSolver; // Plans the opt plans' sequences, its settings are copied with the simulation
+        UndoJournal *undoJournal; // The states before the last state-changing commands
+        WriteAheadLog *writeAheadLog; // Null unless the commands are written ahead to disk
+        // The state, shared with the snapshots taken of it until changed (see SimulationSnapshot)
+        ActionLog actionsLog;
+        PlanStorage plans; // A Plan& into it is only good until the next snapshot, restore or load (see PlanStorage)
+        SharedVector<shared_ptr<Settlement>> settlements; // Settlements never change, the plans refer to them
+        vector<FacilityType> facilitiesOptions; // The plans refer to it, so it stays in place for good
+        shared_ptr<const vector<FacilityType>> sharedFacilitiesOptions; // Copy of facilitiesOptions for the snapshots, made on demand
+        // Lookup indexes, kept in sync with the containers above
+        unordered_map<string, Settlement*> settlementsByName;
+        unordered_map<string, size_t> facilitiesByName; // Position in facilitiesOptions
+        vector<size_t> planIndexById; // Position in plans
+        vector<vector<size_t>> plansByPolicy; // Positions in plans by PolicyType, empty until grouped again (see groupPlans)
+        map<string, SimulationSnapshot*> snapshots; // Named snapshots, owned, listed by name
+        shared_ptr<const SimulationSnapshot> replayBase; // In replay mode, the last checkpoint the state can be replayed from
 };
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+using namespace std;
+using std::string;
+using std::vector;
+
+class StringPool;
+
+// The binary image of a simulation on disk (see Simulation::save and Simulation::load):
+//   magic "SIMIMAGE", version (4 bytes), body size (8 bytes), body, FNV-1a checksum of the body (8 bytes)
+// with the fixed-size fields little-endian. The body is a sequence of variable-length integers
+// (7 bits a byte, signed ones zigzag-encoded) and length-prefixed strings, written and read in the same order.
+// Images of another version are refused rather than guessed at.
+class SimulationImage {
+    public:
+        static const uint32_t version = 2;
+        static const char magic[8];
+        static const size_t headerSize = 20;
+        static uint64_t checksum(const unsigned char *bytes, const size_t size);
+        static vector<unsigned char> readFile(const string &path);
+};
+
+
+// Builds the body of an image in memory, then writes the whole image at once.
+// Given a pool, it writes each string as its number in the pool instead (see ActionLog).
+class ImageWriter {
+    public:
+        ImageWriter();
+        ImageWriter(StringPool &strings);
+        ImageWriter(const ImageWriter &other) = delete;
+        ImageWriter &operator=(const ImageWriter &other) = delete;
+        void writeSize(size_t value);
+        void writeInt(const long long value);
+        void writeString(const string &value);
+        void writeBytes(const vector<unsigned char> &value);
+        const vector<unsigned char> &getBody() const;
+        void writeToFile(const string &path) const;
+
+    private:
+        vector<unsigned char> body;
+        StringPool *strings; // Null unless strings are interned
+};
+
+
+// Reads the body of an image file, mapped into memory rather than read through a stream.
+// The header and the checksum are verified when the file is opened, before anything is read.
+// It can also read a whole image already in memory, checked the same way, or bytes written with or without a pool,
+// reading strings from the same pool.
+class ImageReader {
+    public:
+        ImageReader(const string &path);
+        ImageReader(const vector<unsigned char> &image);
+        ImageReader(const unsigned char *begin, const unsigned char *end);
+        ImageReader(const unsigned char *begin, const unsigned char *end, const StringPool &strings);
+        ImageReader(const ImageReader &other) = delete;
+        ImageReader &operator=(const ImageReader &other) = delete;
+        ~ImageReader();
+        size_t readSize();
+        size_t readSize(const size_t limit); // Throws unless below limit (an index or a count)
+        int readInt();
+        long long readLong();
+        string readString();
+        vector<unsigned char> readBytes();
+        bool atEnd() const;
+        const unsigned char *getPosition() const;
+
+    private:
+        void open(const unsigned char *bytes, const size_t size);
+
+        void *mapping; // Null when reading memory
+        size_t mappingSize;
+        const unsigned char *position;
+        const unsigned char *end;
+        const StringPool *strings; // Null unless strings are interned
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <memory>
+#include <vector>
+#include "ActionLog.h"
+#include "Facility.h"
+#include "PlanStorage.h"
+#include "Settlement.h"
+#include "SharedVector.h"
+
+using namespace std;
+using std::vector;
+
+class BaseAction;
+class Simulation;
+
+// The state of a simulation at some point, to restore it to later (see Simulation::restore).
+// Every part is shared with the simulation, and with other snapshots, until one of them changes it:
+// taking a snapshot is O(1), and holding one costs only what the simulation changed since.
+// The plans keep referring to the simulation's catalog, settlements and indexes, so a snapshot
+// can only be restored into the simulation it was taken of.
+// A replay snapshot (see BackupMode::REPLAY) holds none of the state but its log: it is restored by restoring
+// its base, an earlier full snapshot, and applying the actions logged since then again.
+class SimulationSnapshot {
+    public:
+        SimulationSnapshot(Simulation &simulation);
+        SimulationSnapshot(Simulation &simulation, const shared_ptr<const SimulationSnapshot> &replayBase);
+        bool isReplayed() const;
+        size_t getNumOfPlans() const;
+        size_t getNumOfActions() const;
+        void measure(size_t &uniqueBytes, size_t &totalBytes) const;
+        size_t measureDifference(const SimulationSnapshot &other) const;
+
+    private:
+        friend class Simulation;
+        static size_t measureFacilitiesOptions(const vector<FacilityType> &facilitiesOptions);
+
+        int planCounter;
+        shared_ptr<const vector<FacilityType>> facilitiesOptions; // Immutable copy, shared until a type is added
+        SharedVector<shared_ptr<Settlement>> settlements;
+        PlanStorage plans;
+        ActionLog actionsLog;
+        shared_ptr<const SimulationSnapshot> replayBase; // Null for a full snapshot
+};
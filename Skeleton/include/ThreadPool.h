@@ -0,0 +1,38 @@
+#pragma once
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+// A fixed set of worker threads that run batches of independent tasks.
+// The calling thread takes part in every batch, so a pool of size 1 spawns no threads at all.
+class ThreadPool {
+    public:
+        ThreadPool(int numOfThreads);
+        ThreadPool(const ThreadPool &other) = delete;
+        ThreadPool &operator=(const ThreadPool &other) = delete;
+        ~ThreadPool();
+        int size() const;
+        void run(size_t numOfTasks, const function<void(size_t)> &task);
+
+    private:
+        void work();
+        void runTasks();
+
+        vector<thread> workers;
+        mutex lock;
+        condition_variable wakeUp;
+        condition_variable batchDone;
+        const function<void(size_t)> *task;
+        size_t numOfTasks;
+        size_t nextTask;
+        size_t unfinishedTasks;
+        unsigned long batch;
+        bool stopping;
+        exception_ptr failure;
+        size_t failedTask;
+};
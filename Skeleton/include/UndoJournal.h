@@ -0,0 +1,36 @@
+#pragma once
+#include <deque>
+#include "SimulationSnapshot.h"
+
+using namespace std;
+
+// The states a simulation was in before each of its last state-changing commands, oldest first, to undo them.
+// An entry is a SimulationSnapshot, so it shares everything with the simulation and the other entries but what the
+// command after it changed: that is all it holds, and it is measured once the next entry is recorded.
+// The oldest entries are dropped to keep what the journal holds within its memory limit; the newest entry is
+// always kept, so the last command can be undone however much it changed. A limit of 0 turns the journal off.
+class UndoJournal {
+    public:
+        UndoJournal();
+        UndoJournal(const UndoJournal &other) = delete;
+        UndoJournal &operator=(const UndoJournal &other) = delete;
+        ~UndoJournal();
+        void setMemoryLimit(const size_t memoryLimit);
+        bool isEnabled() const;
+        void record(const SimulationSnapshot &snapshot);
+        const SimulationSnapshot &get(const size_t numOfCommands) const;
+        void drop(const size_t numOfCommands);
+        size_t size() const;
+        size_t getMemoryUsage() const;
+
+    private:
+        struct Entry {
+            SimulationSnapshot *snapshot; // Owned
+            size_t bytes; // Held on top of the next entry, 0 for the newest until the next one is recorded
+        };
+        void dropOldest();
+
+        deque<Entry> entries;
+        size_t memoryLimit;
+        size_t memoryUsage; // Of all the entries
+};
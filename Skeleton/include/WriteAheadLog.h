@@ -0,0 +1,57 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+using namespace std;
+using std::string;
+
+class BaseAction;
+
+// The commands a simulation accepted, appended to a file, so that acting on them again from the configuration
+// rebuilds the state and the log after the process dies (see Simulation::openWriteAheadLog). The commands that change
+// the state are recorded before acting on them; the ones that only print or save, after acting, with how it went, and
+// they are only logged again (see BaseAction::writesAhead). The file is the magic "SIMWALOG", a version (4 bytes),
+// then one record per command:
+//   body size (4 bytes), body, FNV-1a checksum of the body (4 bytes)
+// with the fixed-size fields little-endian. The body is the action's type and arguments (see BaseAction::saveAhead),
+// followed by its status and error message for a command recorded after acting.
+// A record cut short or damaged by a crash ends the log, and is cut off.
+// A record is written as soon as its command is accepted, so it outlives the process, but it only outlives the
+// machine once synced. Syncs are grouped: a sync covers every record written before it, and a background thread makes
+// one every syncInterval milliseconds while records are unsynced, and as soon as syncCount of them are, without holding
+// the simulation up. With a syncInterval of 0 there is no such thread, and appending the syncCount-th unsynced record
+// syncs before its command acts: a syncCount of 1 then syncs every command before acting on it.
+class WriteAheadLog {
+    public:
+        static const uint32_t version = 2;
+        static const char magic[8];
+        static const size_t headerSize = 12;
+        WriteAheadLog(const string &path, const size_t syncCount, const int syncInterval);
+        WriteAheadLog(const WriteAheadLog &other) = delete;
+        WriteAheadLog &operator=(const WriteAheadLog &other) = delete;
+        ~WriteAheadLog();
+        size_t recover(const function<void(BaseAction*)> &execute, const function<void(BaseAction*)> &log);
+        void append(BaseAction &action);
+        size_t getNumOfRecords() const;
+        size_t getNumOfSyncs() const;
+
+    private:
+        void sync();
+        void syncPeriodically();
+
+        int file;
+        const size_t syncCount;
+        const int syncInterval;
+        size_t numOfRecords;
+        size_t numOfUnsynced; // Records written since the last sync started
+        size_t numOfSyncs;
+        bool failed; // A background sync failed, the next append reports it
+        bool stopping;
+        mutable mutex lock; // Guards the counters, between the simulation's thread and the syncer
+        condition_variable wakeUp;
+        thread syncer; // Only started with a syncInterval
+};
@@ -2,6 +2,14 @@
 
 // No rule of 3 needed.
 
+namespace {
+    // The command of each type of action, by type
+    const char *const commandNames[] = {
+        "step", "plan", "settlement", "facility", "planStatus", "changePolicy", "compare", "log", "stats",
+        "close", "backup", "restore", "snapshots", "dropSnapshot", "save", "load", "undo"
+    };
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ************************************************* BaseAction ******************************************************* //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -30,6 +38,171 @@ const string &BaseAction::getErrorMsg() const {
     return errorMsg;
 }
 
+// Writes the action to an image: its type, its outcome, then its arguments
+void BaseAction::save(ImageWriter &writer) const {
+    writer.writeSize(static_cast<size_t>(getType()));
+    writer.writeSize(static_cast<size_t>(status));
+    writer.writeString(errorMsg);
+    saveArguments(writer);
+}
+
+// Reads an action written by save(), as it was after it acted
+BaseAction *BaseAction::load(ImageReader &reader) {
+    ActionType type = static_cast<ActionType>(reader.readSize(static_cast<size_t>(ActionType::UNDO) + 1));
+    ActionStatus status = static_cast<ActionStatus>(reader.readSize(static_cast<size_t>(ActionStatus::ERROR) + 1));
+    string errorMsg = reader.readString();
+    BaseAction *action = loadArguments(type, reader);
+    action->status = status;
+    action->errorMsg = move(errorMsg);
+    return action;
+}
+
+// Builds an action of the given type from the arguments written by saveArguments()
+BaseAction *BaseAction::loadArguments(const ActionType type, ImageReader &reader) {
+    // Arguments are read in order into locals first, so nothing is allocated until all of them are read
+    BaseAction *action = nullptr;
+    switch (type) {
+        case ActionType::STEP: {
+            int numOfSteps = reader.readInt();
+            action = new SimulateStep(numOfSteps);
+            break;
+        }
+        case ActionType::PLAN: {
+            string settlementName = reader.readString();
+            string selectionPolicy = reader.readString();
+            action = new AddPlan(settlementName, selectionPolicy);
+            break;
+        }
+        case ActionType::SETTLEMENT: {
+            string settlementName = reader.readString();
+            SettlementType settlementType = static_cast<SettlementType>(reader.readSize(static_cast<size_t>(SettlementType::METROPOLIS) + 1));
+            action = new AddSettlement(settlementName, settlementType);
+            break;
+        }
+        case ActionType::FACILITY: {
+            string facilityName = reader.readString();
+            FacilityCategory facilityCategory = static_cast<FacilityCategory>(reader.readSize(static_cast<size_t>(FacilityCategory::ENVIRONMENT) + 1));
+            int price = reader.readInt();
+            int lifeQualityScore = reader.readInt();
+            int economyScore = reader.readInt();
+            int environmentScore = reader.readInt();
+            action = new AddFacility(facilityName, facilityCategory, price, lifeQualityScore, economyScore, environmentScore);
+            break;
+        }
+        case ActionType::PLAN_STATUS: {
+            int planId = reader.readInt();
+            action = new PrintPlanStatus(planId);
+            break;
+        }
+        case ActionType::CHANGE_POLICY: {
+            int planId = reader.readInt();
+            string newPolicy = reader.readString();
+            action = new ChangePlanPolicy(planId, newPolicy);
+            break;
+        }
+        case ActionType::COMPARE: {
+            int planId = reader.readInt();
+            int numOfSteps = reader.readInt();
+            action = new ComparePolicies(planId, numOfSteps);
+            break;
+        }
+        case ActionType::LOG: {
+            size_t from = reader.readSize();
+            size_t count = reader.readSize();
+            vector<ActionType> types;
+            for (size_t i = reader.readSize(); i > 0; i--) {
+                types.push_back(static_cast<ActionType>(reader.readSize(static_cast<size_t>(ActionType::UNDO) + 1)));
+            }
+            bool errorsOnly = reader.readSize(2) == 1;
+            action = new PrintActionsLog(from, count, types, errorsOnly);
+            break;
+        }
+        case ActionType::STATS:
+            action = new PrintStats();
+            break;
+        case ActionType::CLOSE:
+            action = new Close();
+            break;
+        case ActionType::BACKUP:
+            action = new BackupSimulation(reader.readString());
+            break;
+        case ActionType::RESTORE:
+            action = new RestoreSimulation(reader.readString());
+            break;
+        case ActionType::SNAPSHOTS:
+            action = new PrintSnapshots();
+            break;
+        case ActionType::DROP_SNAPSHOT:
+            action = new DropSnapshot(reader.readString());
+            break;
+        case ActionType::SAVE:
+            action = new SaveSimulation(reader.readString());
+            break;
+        case ActionType::LOAD:
+            action = new LoadSimulation(reader.readString());
+            break;
+        case ActionType::UNDO: {
+            int numOfCommands = reader.readInt();
+            action = new Undo(numOfCommands);
+            break;
+        }
+        default:
+            throw runtime_error("Invalid image");
+    }
+    return action;
+}
+
+// Whether the action may change the simulation's state (what undo takes back).
+// Undo itself doesn't count: it takes the journal back along with the state.
+bool BaseAction::changesState() const {
+    switch (getType()) {
+        case ActionType::STEP:
+        case ActionType::PLAN:
+        case ActionType::SETTLEMENT:
+        case ActionType::FACILITY:
+        case ActionType::CHANGE_POLICY:
+        case ActionType::RESTORE:
+        case ActionType::LOAD:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Builds an action from the arguments written by saveAhead()
+BaseAction *BaseAction::loadAhead(const ActionType type, ImageReader &reader) {
+    if (type == ActionType::LOAD) {
+        return LoadSimulation::loadAhead(reader);
+    }
+    return loadArguments(type, reader);
+}
+
+// Whether the write-ahead log records the action before it acts: whether acting on it again is needed to get back to
+// the state after it, snapshots and the undo journal included. The commands that only print or save are recorded
+// after acting instead, with how it went, and are only logged again on recovery.
+bool BaseAction::writesAhead() const {
+    switch (getType()) {
+        case ActionType::BACKUP:
+        case ActionType::DROP_SNAPSHOT:
+        case ActionType::UNDO:
+            return true;
+        default:
+            return changesState();
+    }
+}
+
+// Nothing to apply again for actions that don't change the state, or whose change the log already rewinds to
+void BaseAction::replay(Simulation &) const {}
+
+// Nothing to write for actions without arguments
+void BaseAction::saveArguments(ImageWriter &) const {}
+
+// Arguments, as the write-ahead log records them: all that acting on the action again needs, which for most actions
+// is what images record
+void BaseAction::saveAhead(ImageWriter &writer) {
+    saveArguments(writer);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ************************************************* SimulateStep ***************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -39,12 +212,15 @@ SimulateStep::SimulateStep(const int numOfSteps) : numOfSteps(numOfSteps) {}
 
 // Execute the SimulateStep action
 void SimulateStep::act(Simulation &simulation) {
-    for (int i = 0; i < numOfSteps; i++) {
-        simulation.step();
-    }
+    simulation.step(numOfSteps);
     complete();
 }
 
+// Apply the SimulateStep action again
+void SimulateStep::replay(Simulation &simulation) const {
+    simulation.step(numOfSteps);
+}
+
 // Clone
 SimulateStep *SimulateStep::clone() const {
     return new SimulateStep(*this);
@@ -58,6 +234,16 @@ const string SimulateStep::toString() const {
     return oss.str();
 }
 
+// Type
+ActionType SimulateStep::getType() const {
+    return ActionType::STEP;
+}
+
+// Arguments, as images record them
+void SimulateStep::saveArguments(ImageWriter &writer) const {
+    writer.writeInt(numOfSteps);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // *************************************************** AddPlan ******************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -74,15 +260,25 @@ void AddPlan::act(Simulation &simulation) {
             throw runtime_error("Cannot create this plan");
         }
          // Determine the appropriate SelectionPolicy based on the input string
+        // Category policies need a facility of their category, or the plan could never step
         SelectionPolicy *policy = nullptr;
         if (selectionPolicy == "eco") {
-            policy = new EconomySelection();
+            if (!simulation.getCategoryIndex()->hasCategory(FacilityCategory::ECONOMY)) {
+                throw runtime_error("Cannot create this plan");
+            }
+            policy = new EconomySelection(simulation.getCategoryIndex());
         } else if (selectionPolicy == "bal") {
-            policy = new BalancedSelection(0, 0, 0);
+            policy = new BalancedSelection(0, 0, 0, simulation.getScoreIndex());
         } else if (selectionPolicy == "sus") {
-            policy = new SustainabilitySelection();
+            if (!simulation.getCategoryIndex()->hasCategory(FacilityCategory::ENVIRONMENT)) {
+                throw runtime_error("Cannot create this plan");
+            }
+            policy = new SustainabilitySelection(simulation.getCategoryIndex());
         } else if (selectionPolicy == "nve") {
             policy = new NaiveSelection();
+        } else if (selectionPolicy == "opt") {
+            const Settlement &settlement = simulation.getSettlement(settlementName);
+            policy = new OptimalSelection(Plan::getCapacity(settlement.getType()), simulation.getPlanSolver());
         } else {
             throw invalid_argument("Cannot create this plan");
         }
@@ -93,6 +289,11 @@ void AddPlan::act(Simulation &simulation) {
     }
 }
 
+// Apply the AddPlan action again, on a copy since acting records the outcome
+void AddPlan::replay(Simulation &simulation) const {
+    AddPlan(*this).act(simulation);
+}
+
 // Clone
 AddPlan *AddPlan::clone() const {
     return new AddPlan(*this);
@@ -106,6 +307,17 @@ const string AddPlan::toString() const {
     return oss.str();
 }
 
+// Type
+ActionType AddPlan::getType() const {
+    return ActionType::PLAN;
+}
+
+// Arguments, as images record them
+void AddPlan::saveArguments(ImageWriter &writer) const {
+    writer.writeString(settlementName);
+    writer.writeString(selectionPolicy);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ************************************************ AddSettlement ***************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -128,6 +340,11 @@ void AddSettlement::act(Simulation &simulation) {
     }
 }
 
+// Apply the AddSettlement action again, on a copy since acting records the outcome
+void AddSettlement::replay(Simulation &simulation) const {
+    AddSettlement(*this).act(simulation);
+}
+
 // Clone
 AddSettlement *AddSettlement::clone() const {
     return new AddSettlement(*this);
@@ -141,6 +358,17 @@ const string AddSettlement::toString() const {
     return oss.str();
 }
 
+// Type
+ActionType AddSettlement::getType() const {
+    return ActionType::SETTLEMENT;
+}
+
+// Arguments, as images record them
+void AddSettlement::saveArguments(ImageWriter &writer) const {
+    writer.writeString(settlementName);
+    writer.writeSize(static_cast<size_t>(settlementType));
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ************************************************* AddFacility ****************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -167,6 +395,11 @@ void AddFacility::act(Simulation &simulation) {
     }
 }
 
+// Apply the AddFacility action again, on a copy since acting records the outcome
+void AddFacility::replay(Simulation &simulation) const {
+    AddFacility(*this).act(simulation);
+}
+
 // Clone
 AddFacility *AddFacility::clone() const {
     return new AddFacility(*this);
@@ -183,6 +416,21 @@ const string AddFacility::toString() const {
     return oss.str();
 }
 
+// Type
+ActionType AddFacility::getType() const {
+    return ActionType::FACILITY;
+}
+
+// Arguments, as images record them
+void AddFacility::saveArguments(ImageWriter &writer) const {
+    writer.writeString(facilityName);
+    writer.writeSize(static_cast<size_t>(facilityCategory));
+    writer.writeInt(price);
+    writer.writeInt(lifeQualityScore);
+    writer.writeInt(economyScore);
+    writer.writeInt(environmentScore);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // *********************************************** PrintPlanStatus **************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -196,7 +444,8 @@ void PrintPlanStatus::act(Simulation &simulation) {
         if (!simulation.isPlanExists(planId)) {
             throw runtime_error("Plan doesn't exists");
         }
-        cout << simulation.getPlan(planId).toString();
+        const Simulation &printed = simulation; // Reading the plan leaves the snapshots sharing it as they are
+        cout << printed.getPlan(planId).toString();
         complete();
     } catch (const exception &e) {
         error(e.what());
@@ -216,6 +465,16 @@ const string PrintPlanStatus::toString() const {
     return oss.str();
 }
 
+// Type
+ActionType PrintPlanStatus::getType() const {
+    return ActionType::PLAN_STATUS;
+}
+
+// Arguments, as images record them
+void PrintPlanStatus::saveArguments(ImageWriter &writer) const {
+    writer.writeInt(planId);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ********************************************** ChangePlanPolicy **************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -237,29 +496,9 @@ void ChangePlanPolicy::act(Simulation &simulation) {
             throw runtime_error("Cannot change selection policy");
         }
 
-        // Determine the appropriate SelectionPolicy based on the input string
-        SelectionPolicy *policy = nullptr;
-        if (newPolicy == "eco") {
-            policy = new EconomySelection();
-        } else if (newPolicy == "bal") {
-            // Use existing city scores
-            int lifeQualityScore = plan.getlifeQualityScore();
-            int economyScore = plan.getEconomyScore();
-            int environmentScore = plan.getEnvironmentScore();
-            // Add scores for under-construction facilities
-            const auto &underConstruction = plan.getFacilitiesUnderConstruction();
-            for (const Facility *facility : underConstruction) {
-                lifeQualityScore += facility->getLifeQualityScore();
-                economyScore += facility->getEconomyScore();
-                environmentScore += facility->getEnvironmentScore();
-            }   
-            // Set to a bal selectionPolicy according to the current stats.
-            policy = new BalancedSelection(lifeQualityScore, economyScore, environmentScore); 
-        } else if (newPolicy == "sus") {
-            policy = new SustainabilitySelection();
-        } else if (newPolicy == "nve") {
-            policy = new NaiveSelection();
-        } else {
+        // Build the new policy from the plan's current state (category policies need a facility of their category)
+        SelectionPolicy *policy = simulation.createSelectionPolicy(plan, newPolicy);
+        if (policy == nullptr) {
             throw runtime_error("Cannot change selection policy");
         }
         cout << "planID: " << planId << "\npreviousPolicy: " 
@@ -272,6 +511,12 @@ void ChangePlanPolicy::act(Simulation &simulation) {
     }
 }
 
+// Apply the ChangePlanPolicy action again, without printing the change a second time
+void ChangePlanPolicy::replay(Simulation &simulation) const {
+    Plan &plan = simulation.getPlan(planId);
+    plan.setSelectionPolicy(simulation.createSelectionPolicy(plan, newPolicy));
+}
+
 // Clone
 ChangePlanPolicy *ChangePlanPolicy::clone() const {
     return new ChangePlanPolicy(*this);
@@ -284,18 +529,133 @@ const string ChangePlanPolicy::toString() const {
     return oss.str();
 }
 
+// Type
+ActionType ChangePlanPolicy::getType() const {
+    return ActionType::CHANGE_POLICY;
+}
+
+// Arguments, as images record them
+void ChangePlanPolicy::saveArguments(ImageWriter &writer) const {
+    writer.writeInt(planId);
+    writer.writeString(newPolicy);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// *********************************************** ComparePolicies **************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Constructor
+ComparePolicies::ComparePolicies(const int planId, const int numOfSteps) : planId(planId), numOfSteps(numOfSteps) {}
+
+// Execute the ComparePolicies action: forks the plan once per policy, steps the forks side by side
+// and prints the scores each policy would reach. The plan itself is not changed.
+void ComparePolicies::act(Simulation &simulation) {
+    try {
+        if (!simulation.isPlanExists(planId) || numOfSteps < 0) {
+            throw runtime_error("Cannot compare policies");
+        }
+        const Simulation &compared = simulation; // Reading the plan leaves the snapshots sharing it as they are
+        const Plan &plan = compared.getPlan(planId);
+        const string currentPolicy = plan.getSelectionPolicy()->toString();
+
+        // The plan's own policy carries on as a clone, the others start as changePolicy would start them.
+        // A policy that could not select (no facility of its category) gets no fork.
+        const vector<string> policyNames = {"nve", "bal", "eco", "sus", "opt"};
+        PlanStorage forks;
+        vector<int> forkOf(policyNames.size(), -1);
+        for (size_t i = 0; i < policyNames.size(); i++) {
+            if (policyNames[i] == currentPolicy) {
+                if (!plan.canStep()) continue;
+                forks.add(plan);
+            } else {
+                SelectionPolicy *policy = simulation.createSelectionPolicy(plan, policyNames[i]);
+                if (policy == nullptr) continue;
+                forks.add(plan).setSelectionPolicy(policy);
+            }
+            forkOf[i] = static_cast<int>(forks.size()) - 1;
+        }
+        simulation.stepForks(forks, numOfSteps);
+
+        cout << "planID: " << planId << "\nsteps: " << numOfSteps << "\n";
+        cout << left << setw(8) << "Policy" << setw(18) << "LifeQualityScore"
+             << setw(14) << "EconomyScore" << "EnvironmentScore" << "\n";
+        for (size_t i = 0; i < policyNames.size(); i++) {
+            string name = policyNames[i] + (policyNames[i] == currentPolicy ? "*" : "");
+            cout << setw(8) << name;
+            if (forkOf[i] == -1) {
+                cout << setw(18) << "-" << setw(14) << "-" << "-" << "\n";
+                continue;
+            }
+            const Plan &fork = forks[forkOf[i]];
+            cout << setw(18) << fork.getlifeQualityScore() << setw(14) << fork.getEconomyScore()
+                 << fork.getEnvironmentScore() << "\n";
+        }
+        cout << right << flush;
+        complete();
+    } catch (const exception &e) {
+        error(e.what());
+    }
+}
+
+// Clone
+ComparePolicies *ComparePolicies::clone() const {
+    return new ComparePolicies(*this);
+}
+
+// Convert ComparePolicies action to a string
+const string ComparePolicies::toString() const {
+    ostringstream oss;
+    oss << "compare " << planId << " " << numOfSteps << " "
+        << ((getStatus() == ActionStatus::COMPLETED) ? "COMPLETED" : "ERROR");
+    return oss.str();
+}
+
+// Type
+ActionType ComparePolicies::getType() const {
+    return ActionType::COMPARE;
+}
+
+// Arguments, as images record them
+void ComparePolicies::saveArguments(ImageWriter &writer) const {
+    writer.writeInt(planId);
+    writer.writeInt(numOfSteps);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // *********************************************** PrintActionsLog **************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
+const size_t PrintActionsLog::allActions;
+
 // Constructor
-PrintActionsLog::PrintActionsLog() {}
+PrintActionsLog::PrintActionsLog(const size_t from, const size_t count, const vector<ActionType> &types, const bool errorsOnly)
+    : from(from), count(count), types(types), errorsOnly(errorsOnly) {}
 
-// Execute the PrintActionsLog action
-void PrintActionsLog::act(Simulation &simulation) {
-    for (const auto &action : simulation.getActionsLog()) {
-        cout << action->toString() << endl;
+// The type of the actions of a command, by the command's name
+ActionType PrintActionsLog::parseType(const string &name) {
+    for (size_t type = 0; type < sizeof(commandNames) / sizeof(commandNames[0]); type++) {
+        if (name == commandNames[type]) {
+            return static_cast<ActionType>(type);
+        }
     }
+    throw runtime_error("Invalid log command");
+}
+
+// Execute the PrintActionsLog action, rebuilding the matching actions from the log one at a time.
+// The lines are gathered and written a buffer at a time rather than flushed one by one.
+void PrintActionsLog::act(Simulation &simulation) {
+    const size_t bufferSize = 1 << 16;
+    string buffer;
+    simulation.getActionsLog().visit(types, errorsOnly, from, count, [&buffer](const BaseAction &action) {
+        buffer += action.toString();
+        buffer += '\n';
+        if (buffer.size() >= bufferSize) {
+            cout.write(buffer.data(), buffer.size());
+            buffer.clear();
+        }
+    });
+    cout.write(buffer.data(), buffer.size());
+    cout.flush();
     complete();
 }
 
@@ -307,11 +667,81 @@ PrintActionsLog *PrintActionsLog::clone() const {
 // Convert PrintActionsLog action to a string
 const string PrintActionsLog::toString() const {
     ostringstream oss;
-    oss << "log "
-        << ((getStatus() == ActionStatus::COMPLETED) ? "COMPLETED" : "ERROR");
+    oss << "log ";
+    if (from > 0 || count != allActions) {
+        oss << from << " ";
+    }
+    if (count != allActions) {
+        oss << count << " ";
+    }
+    for (ActionType type : types) {
+        oss << "--type=" << commandNames[static_cast<size_t>(type)] << " ";
+    }
+    if (errorsOnly) {
+        oss << "--errors ";
+    }
+    oss << ((getStatus() == ActionStatus::COMPLETED) ? "COMPLETED" : "ERROR");
     return oss.str();
 }
 
+// Type
+ActionType PrintActionsLog::getType() const {
+    return ActionType::LOG;
+}
+
+// Arguments, as images record them
+void PrintActionsLog::saveArguments(ImageWriter &writer) const {
+    writer.writeSize(from);
+    writer.writeSize(count);
+    writer.writeSize(types.size());
+    for (ActionType type : types) {
+        writer.writeSize(static_cast<size_t>(type));
+    }
+    writer.writeSize(errorsOnly ? 1 : 0);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ************************************************* PrintStats ******************************************************* //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Constructor
+PrintStats::PrintStats() {}
+
+// Execute the PrintStats action: prints the allocation, balanced selection, opt solver, undo journal and write-ahead
+// log counters
+void PrintStats::act(Simulation &simulation) {
+    const PlanSolver *planSolver = simulation.getPlanSolver();
+    cout << "FacilitiesCreated: " << FacilityPool::getNumOfCreatedFacilities() << "\n";
+    cout << "FacilityChunkAllocations: " << FacilityPool::getNumOfChunkAllocations() << "\n";
+    cout << "BalancedCacheHits: " << simulation.getScoreIndex()->getNumOfCacheHits() << "\n";
+    cout << "BalancedCacheMisses: " << simulation.getScoreIndex()->getNumOfCacheMisses() << "\n";
+    cout << "OptimalSolves: " << planSolver->getNumOfSolves() << "\n";
+    cout << "OptimalNodes: " << planSolver->getNumOfNodes() << "\n";
+    cout << "OptimalMemoHits: " << planSolver->getNumOfMemoHits() << "\n";
+    cout << "OptimalSolveMicroseconds: " << planSolver->getSolveMicroseconds() << "\n";
+    cout << "UndoJournalEntries: " << simulation.getUndoJournal()->size() << "\n";
+    cout << "UndoJournalBytes: " << simulation.getUndoJournal()->getMemoryUsage() << "\n";
+    const WriteAheadLog *writeAheadLog = simulation.getWriteAheadLog();
+    cout << "WriteAheadRecords: " << (writeAheadLog ? writeAheadLog->getNumOfRecords() : 0) << "\n";
+    cout << "WriteAheadSyncs: " << (writeAheadLog ? writeAheadLog->getNumOfSyncs() : 0) << endl;
+    complete();
+}
+
+// Clone
+PrintStats *PrintStats::clone() const {
+    return new PrintStats(*this);
+}
+
+// Convert PrintStats action to a string
+const string PrintStats::toString() const {
+    return "stats COMPLETED";
+}
+
+// Type
+ActionType PrintStats::getType() const {
+    return ActionType::STATS;
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // *************************************************** Close ********************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -335,20 +765,33 @@ const string Close::toString() const {
     return "close COMPLETED";
 }
 
+// Type
+ActionType Close::getType() const {
+    return ActionType::CLOSE;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // *********************************************** BackupSimulation *************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Constructor 
-BackupSimulation::BackupSimulation() {}
+// Constructor: the backup
+BackupSimulation::BackupSimulation() : snapshotName() {}
+
+// Constructor: a named snapshot
+BackupSimulation::BackupSimulation(const string &snapshotName) : snapshotName(snapshotName) {}
 
 // Execute the BackupSimulation action
 void BackupSimulation::act(Simulation &simulation) {
+    if (!snapshotName.empty()) {
+        simulation.addSnapshot(snapshotName);
+        complete();
+        return;
+    }
     if (backup != nullptr) {
         delete backup;
     }
-    backup = new Simulation(simulation);
+    backup = simulation.takeSnapshot();
     complete();
 }
 
@@ -359,26 +802,48 @@ BackupSimulation *BackupSimulation::clone() const {
 
 // Convert BackupSimulation action to a string
 const string BackupSimulation::toString() const {
-    return "backup COMPLETED";
+    return snapshotName.empty() ? "backup COMPLETED" : "backup " + snapshotName + " COMPLETED";
+}
+
+// Type
+ActionType BackupSimulation::getType() const {
+    return ActionType::BACKUP;
+}
+
+// Arguments, as images record them
+void BackupSimulation::saveArguments(ImageWriter &writer) const {
+    writer.writeString(snapshotName);
 }
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ********************************************** RestoreSimulation *************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-// Constructor
-RestoreSimulation::RestoreSimulation() {}
+// Constructor: the backup
+RestoreSimulation::RestoreSimulation() : snapshotName() {}
+
+// Constructor: a named snapshot
+RestoreSimulation::RestoreSimulation(const string &snapshotName) : snapshotName(snapshotName) {}
 
 // Execute the RestoreSimulation action
 void RestoreSimulation::act(Simulation &simulation) {
     try {
+        if (!snapshotName.empty()) {
+            if (!simulation.isSnapshotExists(snapshotName)) {
+                throw runtime_error("Snapshot doesn't exist");
+            }
+            simulation.restore(simulation.getSnapshot(snapshotName));
+            complete();
+            return;
+        }
+
         // Check if a backup exists
         if (backup == nullptr) {
             throw runtime_error("No backup available");
         }
 
         // Restore the simulation by overwriting the current state with the backup
-        simulation = *backup; 
+        simulation.restore(*backup);
         complete();
     } catch (const exception &e) {
         error(e.what());
@@ -393,7 +858,250 @@ RestoreSimulation *RestoreSimulation::clone() const {
 // Convert RestoreSimulation action to a string
 const string RestoreSimulation::toString() const {
     ostringstream oss;
-    oss << "restore "
+    oss << "restore " << (snapshotName.empty() ? "" : snapshotName + " ")
         << ((getStatus() == ActionStatus::COMPLETED) ? "COMPLETED" : "ERROR");
     return oss.str();
-}
\ No newline at end of file
+}
+
+// Type
+ActionType RestoreSimulation::getType() const {
+    return ActionType::RESTORE;
+}
+
+// Arguments, as images record them
+void RestoreSimulation::saveArguments(ImageWriter &writer) const {
+    writer.writeString(snapshotName);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// *********************************************** PrintSnapshots ***************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Constructor
+PrintSnapshots::PrintSnapshots() {}
+
+// Execute the PrintSnapshots action: each named snapshot with what it holds, and what dropping it would free
+void PrintSnapshots::act(Simulation &simulation) {
+    for (const auto &named : simulation.getSnapshots()) {
+        size_t uniqueBytes = 0, totalBytes = 0;
+        named.second->measure(uniqueBytes, totalBytes);
+        cout << "SnapshotName: " << named.first << "\n";
+        cout << "Plans: " << named.second->getNumOfPlans() << "\n";
+        cout << "Actions: " << named.second->getNumOfActions() << "\n";
+        cout << "UniqueBytes: " << uniqueBytes << "\n";
+        cout << "SharedBytes: " << totalBytes - uniqueBytes << endl;
+    }
+    complete();
+}
+
+// Clone
+PrintSnapshots *PrintSnapshots::clone() const {
+    return new PrintSnapshots(*this);
+}
+
+// Convert PrintSnapshots action to a string
+const string PrintSnapshots::toString() const {
+    return "snapshots COMPLETED";
+}
+
+// Type
+ActionType PrintSnapshots::getType() const {
+    return ActionType::SNAPSHOTS;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ************************************************ DropSnapshot ****************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Constructor
+DropSnapshot::DropSnapshot(const string &snapshotName) : snapshotName(snapshotName) {}
+
+// Execute the DropSnapshot action
+void DropSnapshot::act(Simulation &simulation) {
+    if (!simulation.isSnapshotExists(snapshotName)) {
+        error("Snapshot doesn't exist");
+        return;
+    }
+    simulation.dropSnapshot(snapshotName);
+    complete();
+}
+
+// Clone
+DropSnapshot *DropSnapshot::clone() const {
+    return new DropSnapshot(*this);
+}
+
+// Convert DropSnapshot action to a string
+const string DropSnapshot::toString() const {
+    ostringstream oss;
+    oss << "dropSnapshot " << snapshotName << " " << ((getStatus() == ActionStatus::COMPLETED) ? "COMPLETED" : "ERROR");
+    return oss.str();
+}
+
+// Type
+ActionType DropSnapshot::getType() const {
+    return ActionType::DROP_SNAPSHOT;
+}
+
+// Arguments, as images record them
+void DropSnapshot::saveArguments(ImageWriter &writer) const {
+    writer.writeString(snapshotName);
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// *********************************************** SaveSimulation ***************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Constructor
+SaveSimulation::SaveSimulation(const string &path) : path(path) {}
+
+// Execute the SaveSimulation action
+void SaveSimulation::act(Simulation &simulation) {
+    try {
+        simulation.save(path);
+        complete();
+    } catch (const exception &e) {
+        error(e.what());
+    }
+}
+
+// Clone
+SaveSimulation *SaveSimulation::clone() const {
+    return new SaveSimulation(*this);
+}
+
+// Convert SaveSimulation action to a string
+const string SaveSimulation::toString() const {
+    ostringstream oss;
+    oss << "save " << path << " " << ((getStatus() == ActionStatus::COMPLETED) ? "COMPLETED" : "ERROR");
+    return oss.str();
+}
+
+// Type
+ActionType SaveSimulation::getType() const {
+    return ActionType::SAVE;
+}
+
+// Arguments, as images record them
+void SaveSimulation::saveArguments(ImageWriter &writer) const {
+    writer.writeString(path);
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// *********************************************** LoadSimulation ***************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Constructor
+LoadSimulation::LoadSimulation(const string &path) : path(path), image(), imageError() {}
+
+// Execute the LoadSimulation action. Once written ahead, it loads the image its record holds, or fails as reading it did.
+void LoadSimulation::act(Simulation &simulation) {
+    try {
+        if (image) {
+            simulation.load(*image);
+        } else if (!imageError.empty()) {
+            throw runtime_error(imageError);
+        } else {
+            simulation.load(path);
+        }
+        complete();
+    } catch (const exception &e) {
+        error(e.what());
+    }
+}
+
+// Clone
+LoadSimulation *LoadSimulation::clone() const {
+    return new LoadSimulation(*this);
+}
+
+// Convert LoadSimulation action to a string
+const string LoadSimulation::toString() const {
+    ostringstream oss;
+    oss << "load " << path << " " << ((getStatus() == ActionStatus::COMPLETED) ? "COMPLETED" : "ERROR");
+    return oss.str();
+}
+
+// Type
+ActionType LoadSimulation::getType() const {
+    return ActionType::LOAD;
+}
+
+// Arguments, as images record them
+void LoadSimulation::saveArguments(ImageWriter &writer) const {
+    writer.writeString(path);
+}
+
+// Arguments, as the write-ahead log records them: the path, then the image file's bytes, or why they couldn't be read.
+// The file is read once, for both the record and act(), so acting on the record again loads the same state
+// whatever the file holds by then.
+void LoadSimulation::saveAhead(ImageWriter &writer) {
+    try {
+        image = make_shared<const vector<unsigned char>>(SimulationImage::readFile(path));
+    } catch (const exception &e) {
+        imageError = e.what();
+    }
+    writer.writeString(path);
+    writer.writeSize(image ? 1 : 0);
+    if (image) {
+        writer.writeBytes(*image);
+    } else {
+        writer.writeString(imageError);
+    }
+}
+
+// Rebuilds a load from the arguments written by saveAhead()
+LoadSimulation *LoadSimulation::loadAhead(ImageReader &reader) {
+    string path = reader.readString();
+    shared_ptr<const vector<unsigned char>> image;
+    string imageError;
+    if (reader.readSize(2) == 1) {
+        image = make_shared<const vector<unsigned char>>(reader.readBytes());
+    } else {
+        imageError = reader.readString();
+    }
+    LoadSimulation *action = new LoadSimulation(path);
+    action->image = image;
+    action->imageError = imageError;
+    return action;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// **************************************************** Undo ********************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Constructor
+Undo::Undo(const int numOfCommands) : numOfCommands(numOfCommands) {}
+
+// Execute the Undo action
+void Undo::act(Simulation &simulation) {
+    try {
+        simulation.undo(numOfCommands);
+        complete();
+    } catch (const exception &e) {
+        error(e.what());
+    }
+}
+
+// Clone
+Undo *Undo::clone() const {
+    return new Undo(*this);
+}
+
+// Convert Undo action to a string
+const string Undo::toString() const {
+    ostringstream oss;
+    oss << "undo " << numOfCommands << " " << ((getStatus() == ActionStatus::COMPLETED) ? "COMPLETED" : "ERROR");
+    return oss.str();
+}
+
+// Type
+ActionType Undo::getType() const {
+    return ActionType::UNDO;
+}
+
+// Arguments, as images record them
+void Undo::saveArguments(ImageWriter &writer) const {
+    writer.writeInt(numOfCommands);
+}
@@ -0,0 +1,356 @@
+#include "ActionLog.h"
+#include "Action.h"
+#include "SimulationImage.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+    // A record's tag is its type and whether it failed, and the records are indexed by tag
+    const size_t numOfTags = (static_cast<size_t>(ActionType::UNDO) + 1) << 1;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ************************************************* StringPool ******************************************************* //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// No rule of 3 needed - The strings are owned by the map, their addresses don't change.
+
+// Constructor: empty
+StringPool::StringPool() : ids(), strings() {}
+
+// The number of a string, adding it if it isn't in the pool yet
+size_t StringPool::intern(const string &value) {
+    auto interned = ids.find(value);
+    if (interned != ids.end()) {
+        return interned->second;
+    }
+    interned = ids.emplace(value, strings.size()).first;
+    strings.push_back(&interned->first);
+    return interned->second;
+}
+
+const string &StringPool::get(const size_t id) const {
+    return *strings[id];
+}
+
+size_t StringPool::size() const {
+    return strings.size();
+}
+
+// Bytes of the strings and of the tables that find them
+size_t StringPool::getMemoryUsage() const {
+    size_t bytes = strings.capacity() * sizeof(const string*) + ids.bucket_count() * sizeof(void*);
+    for (const string *value : strings) {
+        bytes += sizeof(pair<const string, size_t>) + sizeof(void*) + value->capacity();
+    }
+    return bytes;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ************************************************* ActionLog ******************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// No rule of 3 needed - Copies share the arena and the pool, which are released by their last owner.
+
+const size_t ActionLog::blockSize;
+const size_t ActionLog::indexChunkSize;
+
+// Constructor: an arena with no blocks and an empty index per tag
+ActionLog::Arena::Arena(const size_t numOfRecords) : blocks(), indexes(numOfTags), numOfRecords(numOfRecords) {}
+
+// Constructor: empty, with a pool of its own
+ActionLog::ActionLog() : arena(), numOfRecords(0), numOfBlocks(0), lastBlockSize(0), strings(make_shared<StringPool>()) {}
+
+size_t ActionLog::size() const {
+    return numOfRecords;
+}
+
+bool ActionLog::empty() const {
+    return numOfRecords == 0;
+}
+
+// Appends the record of an action that has acted
+void ActionLog::append(const BaseAction &action) {
+    ImageWriter writer(*strings);
+    bool failed = action.getStatus() == ActionStatus::ERROR;
+    size_t tag = (static_cast<size_t>(action.getType()) << 1) | (failed ? 1 : 0);
+    writer.writeSize(tag);
+    if (failed) {
+        writer.writeString(action.getErrorMsg());
+    }
+    action.saveArguments(writer);
+    const vector<unsigned char> &record = writer.getBody();
+    if (record.size() > blockSize) {
+        throw runtime_error("Action too long to log");
+    }
+
+    if (!arena || arena->numOfRecords != numOfRecords) {
+        branch();
+    }
+    if (numOfBlocks == 0 || lastBlockSize + record.size() > blockSize) {
+        arena->blocks.push_back(make_shared<Block>(numOfRecords));
+        numOfBlocks++;
+        lastBlockSize = 0;
+    }
+    Index &index = arena->indexes[tag];
+    if (index.size % indexChunkSize == 0) {
+        index.chunks.push_back(make_shared<IndexChunk>());
+    }
+    index.chunks.back()->positions[index.size % indexChunkSize] = endPosition();
+    index.size++;
+
+    Block &block = *arena->blocks.back();
+    memcpy(block.bytes + lastBlockSize, record.data(), record.size());
+    lastBlockSize += record.size();
+    block.size = lastBlockSize;
+    numOfRecords++;
+    arena->numOfRecords = numOfRecords;
+}
+
+// Drops all the records (the copies sharing them keep theirs), the pool is kept
+void ActionLog::clear() {
+    arena.reset();
+    numOfRecords = 0;
+    numOfBlocks = 0;
+    lastBlockSize = 0;
+}
+
+// Rebuilds the actions from begin to end, in order, and passes each one to visit. Each action is released once
+// visited, so visit must not keep it. Reaching begin takes decoding the records before it in its block.
+void ActionLog::visit(const size_t begin, const size_t end, const function<void(const BaseAction&)> &visit) const {
+    if (begin >= end) return;
+    size_t block = findBlock(begin);
+    size_t record = arena->blocks[block]->firstRecord;
+    size_t offset = 0;
+    while (record < end) {
+        if (offset == (block + 1 == numOfBlocks ? lastBlockSize : arena->blocks[block]->size)) {
+            block++;
+            offset = 0;
+            continue;
+        }
+        BaseAction *action = decode(block, offset);
+        if (record >= begin) {
+            try {
+                visit(*action);
+            } catch (...) {
+                delete action;
+                throw;
+            }
+        }
+        delete action;
+        record++;
+    }
+}
+
+// Rebuilds the actions of the given types (all of them if none is given), only the failed ones if errorsOnly,
+// and passes count of them to visit in order, skipping the first from of them. The indexes of the matching tags are
+// merged, so only the actions visited are rebuilt, and from is found by a binary search over the positions.
+void ActionLog::visit(const vector<ActionType> &types, const bool errorsOnly, const size_t from, const size_t count,
+                      const function<void(const BaseAction&)> &visit) const {
+    if (types.empty() && !errorsOnly) {
+        if (from < numOfRecords) {
+            this->visit(from, from + min(count, numOfRecords - from), visit);
+        }
+        return;
+    }
+    if (!arena || count == 0) return;
+
+    vector<const Index*> indexes;
+    vector<size_t> sizes;
+    for (size_t tag = 0; tag < numOfTags; tag++) {
+        bool isType = types.empty() || find(types.begin(), types.end(), static_cast<ActionType>(tag >> 1)) != types.end();
+        if (isType && (!errorsOnly || (tag & 1))) {
+            indexes.push_back(&arena->indexes[tag]);
+            sizes.push_back(countIndexed(arena->indexes[tag]));
+        }
+    }
+
+    vector<size_t> cursors(indexes.size(), 0);
+    if (from > 0) {
+        // The first position with more than from matching records before it is just past the one to start at
+        auto countBefore = [&](const size_t position) {
+            size_t numOfMatching = 0;
+            for (size_t i = 0; i < indexes.size(); i++) {
+                numOfMatching += lowerBound(*indexes[i], sizes[i], position);
+            }
+            return numOfMatching;
+        };
+        size_t low = 0, high = endPosition();
+        if (countBefore(high) <= from) return;
+        while (high - low > 1) {
+            size_t middle = low + (high - low) / 2;
+            if (countBefore(middle) > from) {
+                high = middle;
+            } else {
+                low = middle;
+            }
+        }
+        for (size_t i = 0; i < indexes.size(); i++) {
+            cursors[i] = lowerBound(*indexes[i], sizes[i], high - 1);
+        }
+    }
+
+    for (size_t visited = 0; visited < count; visited++) {
+        const size_t none = indexes.size();
+        size_t next = none, nextPosition = 0;
+        for (size_t i = 0; i < indexes.size(); i++) {
+            if (cursors[i] < sizes[i]) {
+                size_t position = indexes[i]->chunks[cursors[i] / indexChunkSize]->positions[cursors[i] % indexChunkSize];
+                if (next == none || position < nextPosition) {
+                    next = i;
+                    nextPosition = position;
+                }
+            }
+        }
+        if (next == none) break;
+        visitAt(nextPosition, visit);
+        cursors[next]++;
+    }
+}
+
+// Adds the bytes of this log's blocks and pool to totalBytes, and of those no other log shares to uniqueBytes.
+// isUnique tells whether the log itself is held by a single owner.
+void ActionLog::measure(const bool isUnique, size_t &uniqueBytes, size_t &totalBytes) const {
+    size_t poolBytes = strings->getMemoryUsage();
+    totalBytes += poolBytes;
+    uniqueBytes += (isUnique && strings.use_count() == 1) ? poolBytes : 0;
+    if (!arena) return;
+    bool isArenaUnique = isUnique && arena.use_count() == 1;
+    size_t tableBytes = sizeof(Arena) + arena->blocks.capacity() * sizeof(shared_ptr<Block>);
+    totalBytes += tableBytes;
+    uniqueBytes += isArenaUnique ? tableBytes : 0;
+    for (size_t i = 0; i < numOfBlocks; i++) {
+        totalBytes += sizeof(Block);
+        uniqueBytes += (isArenaUnique && arena->blocks[i].use_count() == 1) ? sizeof(Block) : 0;
+    }
+    for (const Index &index : arena->indexes) {
+        size_t indexBytes = index.chunks.capacity() * sizeof(shared_ptr<IndexChunk>);
+        totalBytes += indexBytes;
+        uniqueBytes += isArenaUnique ? indexBytes : 0;
+        size_t numOfChunks = (countIndexed(index) + indexChunkSize - 1) / indexChunkSize;
+        for (size_t i = 0; i < numOfChunks; i++) {
+            totalBytes += sizeof(IndexChunk);
+            uniqueBytes += (isArenaUnique && index.chunks[i].use_count() == 1) ? sizeof(IndexChunk) : 0;
+        }
+    }
+}
+
+// Adds the bytes of this log's blocks and index chunks that other doesn't share to bytes: what this log holds on
+// top of other. The pool is shared by all the copies, so it is never counted.
+void ActionLog::measureDifference(const ActionLog &other, size_t &bytes) const {
+    if (!arena) return;
+    if (arena == other.arena) {
+        bytes += (numOfBlocks > other.numOfBlocks) ? (numOfBlocks - other.numOfBlocks) * sizeof(Block) : 0;
+        for (const Index &index : arena->indexes) {
+            size_t numOfChunks = (countIndexed(index) + indexChunkSize - 1) / indexChunkSize;
+            size_t numOfOtherChunks = (other.countIndexed(index) + indexChunkSize - 1) / indexChunkSize;
+            bytes += (numOfChunks > numOfOtherChunks) ? (numOfChunks - numOfOtherChunks) * sizeof(IndexChunk) : 0;
+        }
+        return;
+    }
+    bytes += sizeof(Arena) + arena->blocks.capacity() * sizeof(shared_ptr<Block>);
+    for (size_t i = 0; i < numOfBlocks; i++) {
+        if (!other.arena || i >= other.numOfBlocks || arena->blocks[i] != other.arena->blocks[i]) {
+            bytes += sizeof(Block);
+        }
+    }
+    for (size_t tag = 0; tag < numOfTags; tag++) {
+        const Index &index = arena->indexes[tag];
+        bytes += index.chunks.capacity() * sizeof(shared_ptr<IndexChunk>);
+        size_t numOfChunks = (countIndexed(index) + indexChunkSize - 1) / indexChunkSize;
+        const vector<shared_ptr<IndexChunk>> *otherChunks = other.arena ? &other.arena->indexes[tag].chunks : nullptr;
+        for (size_t i = 0; i < numOfChunks; i++) {
+            if (!otherChunks || i >= otherChunks->size() || index.chunks[i] != (*otherChunks)[i]) {
+                bytes += sizeof(IndexChunk);
+            }
+        }
+    }
+}
+
+// Takes an arena of this log's own before appending, when another copy appended after it (or there is none yet).
+// The full blocks and index chunks are shared, the last ones are copied since the other copy may have appended to them.
+void ActionLog::branch() {
+    shared_ptr<Arena> own = make_shared<Arena>(numOfRecords);
+    if (arena) {
+        own->blocks.assign(arena->blocks.begin(), arena->blocks.begin() + numOfBlocks);
+        if (numOfBlocks > 0) {
+            own->blocks.back() = make_shared<Block>(*own->blocks.back());
+            own->blocks.back()->size = lastBlockSize;
+        }
+        for (size_t tag = 0; tag < numOfTags; tag++) {
+            const Index &index = arena->indexes[tag];
+            Index &ownIndex = own->indexes[tag];
+            ownIndex.size = countIndexed(index);
+            ownIndex.chunks.assign(index.chunks.begin(), index.chunks.begin() + (ownIndex.size + indexChunkSize - 1) / indexChunkSize);
+            if (ownIndex.size % indexChunkSize != 0) {
+                ownIndex.chunks.back() = make_shared<IndexChunk>(*ownIndex.chunks.back());
+            }
+        }
+    }
+    arena = own;
+}
+
+// The block the record starts in
+size_t ActionLog::findBlock(const size_t record) const {
+    size_t low = 0, high = numOfBlocks;
+    while (high - low > 1) {
+        size_t middle = (low + high) / 2;
+        if (arena->blocks[middle]->firstRecord <= record) {
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// The position the next record of this log goes to
+size_t ActionLog::endPosition() const {
+    return (numOfBlocks == 0) ? 0 : (numOfBlocks - 1) * blockSize + lastBlockSize;
+}
+
+// The number of the first of the first size positions in an index that isn't before position
+size_t ActionLog::lowerBound(const Index &index, const size_t size, const size_t position) const {
+    size_t low = 0, high = size;
+    while (low < high) {
+        size_t middle = low + (high - low) / 2;
+        if (index.chunks[middle / indexChunkSize]->positions[middle % indexChunkSize] < position) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+// The number of this log's records in an index of its arena, whose longest copy may have indexed more
+size_t ActionLog::countIndexed(const Index &index) const {
+    return (arena->numOfRecords == numOfRecords) ? index.size : lowerBound(index, index.size, endPosition());
+}
+
+// Rebuilds the action recorded at offset in a block, and moves offset past its record
+BaseAction *ActionLog::decode(const size_t block, size_t &offset) const {
+    const Block &bytes = *arena->blocks[block];
+    ImageReader reader(bytes.bytes + offset, bytes.bytes + (block + 1 == numOfBlocks ? lastBlockSize : bytes.size), *strings);
+    size_t tag = reader.readSize();
+    string errorMsg = (tag & 1) ? reader.readString() : "";
+    BaseAction *action = BaseAction::loadArguments(static_cast<ActionType>(tag >> 1), reader);
+    action->status = (tag & 1) ? ActionStatus::ERROR : ActionStatus::COMPLETED;
+    action->errorMsg = move(errorMsg);
+    offset = reader.getPosition() - bytes.bytes;
+    return action;
+}
+
+// Rebuilds the action recorded at a position and passes it to visit
+void ActionLog::visitAt(const size_t position, const function<void(const BaseAction&)> &visit) const {
+    size_t offset = position % blockSize;
+    BaseAction *action = decode(position / blockSize, offset);
+    try {
+        visit(*action);
+    } catch (...) {
+        delete action;
+        throw;
+    }
+    delete action;
+}
@@ -0,0 +1,53 @@
+#include "CategoryIndex.h"
+#include <algorithm>
+
+// No rule of 3 needed - Only holds catalog positions.
+
+// Constructor: an empty catalog
+CategoryIndex::CategoryIndex() : positions(), numOfTypes(0) {}
+
+// Indexes the type that was just added at the end of the catalog
+void CategoryIndex::add(const FacilityType &type) {
+    positions[static_cast<int>(type.getCategory())].push_back(static_cast<int>(numOfTypes));
+    numOfTypes++;
+}
+
+// Indexes a whole catalog from scratch
+void CategoryIndex::rebuild(const vector<FacilityType> &facilityOptions) {
+    for (vector<int> &category : positions) {
+        category.clear();
+    }
+    numOfTypes = 0;
+    for (const FacilityType &type : facilityOptions) {
+        add(type);
+    }
+}
+
+// Checks whether the index covers this catalog as it is now
+bool CategoryIndex::isBuiltFor(const vector<FacilityType> &facilityOptions) const {
+    return numOfTypes == facilityOptions.size();
+}
+
+// Whether the catalog has any type of the category
+bool CategoryIndex::hasCategory(const FacilityCategory category) const {
+    return !positions[static_cast<int>(category)].empty();
+}
+
+// Catalog index of the first type of the category after lastSelectedIndex, going around the catalog,
+// or -1 if there is none. position is where lastSelectedIndex sits in the category: when it is right,
+// the answer is the next one, otherwise it is searched for. Either way it is moved to the answer.
+int CategoryIndex::findNext(const FacilityCategory category, const int lastSelectedIndex, size_t &position) const {
+    const vector<int> &indices = positions[static_cast<int>(category)];
+    if (indices.empty()) {
+        return -1;
+    }
+    if (position < indices.size() && indices[position] == lastSelectedIndex) {
+        position++;
+    } else {
+        position = upper_bound(indices.begin(), indices.end(), lastSelectedIndex) - indices.begin();
+    }
+    if (position == indices.size()) {
+        position = 0;
+    }
+    return indices[position];
+}
@@ -1,4 +1,7 @@
 #include "Facility.h"
+#include "Settlement.h"
+#include <algorithm>
+#include <type_traits>
 
 // No rule of 3 needed
 
@@ -35,6 +38,12 @@ FacilityCategory FacilityType::getCategory() const {
     return category;
 }
 
+// Same name, category, price and scores
+bool FacilityType::operator==(const FacilityType &other) const {
+    return name == other.name && category == other.category && price == other.price && lifeQuality_score == other.lifeQuality_score &&
+           economy_score == other.economy_score && environment_score == other.environment_score;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ************************************************** Facility ******************************************************** //
@@ -42,27 +51,52 @@ FacilityCategory FacilityType::getCategory() const {
 
 // No rule of 3 needed here
 
-// Constructor: creates a Facility from detailed fields
-Facility::Facility(const string &name, const string &settlementName, const FacilityCategory category, const int price, const int lifeQuality_score, const int economy_score, const int environment_score)
-    : FacilityType(name, category, price, lifeQuality_score, economy_score, environment_score), 
-      settlementName(settlementName), 
-      status(FacilityStatus::UNDER_CONSTRUCTIONS), 
-      timeLeft(price) 
+// Constructor: creates a Facility of the catalog's typeIndex-th type
+Facility::Facility(const vector<FacilityType> &facilityOptions, const int typeIndex, const Settlement &settlement)
+    : facilityOptions(&facilityOptions),
+      settlement(&settlement),
+      typeIndex(typeIndex),
+      timeLeft(facilityOptions[typeIndex].getCost()),
+      status(FacilityStatus::UNDER_CONSTRUCTIONS)
 {
 }
 
-// Constructor: creates a Facility from an existing FacilityType
-Facility::Facility(const FacilityType &type, const string &settlementName)
-    : FacilityType(type), 
-      settlementName(settlementName), 
-      status(FacilityStatus::UNDER_CONSTRUCTIONS), 
-      timeLeft(price) 
-{
+// Type's fields, looked up in the catalog
+const FacilityType &Facility::getType() const {
+    return (*facilityOptions)[typeIndex];
+}
+
+int Facility::getTypeIndex() const {
+    return typeIndex;
+}
+
+const string &Facility::getName() const {
+    return getType().getName();
+}
+
+int Facility::getCost() const {
+    return getType().getCost();
+}
+
+int Facility::getLifeQualityScore() const {
+    return getType().getLifeQualityScore();
+}
+
+int Facility::getEnvironmentScore() const {
+    return getType().getEnvironmentScore();
+}
+
+int Facility::getEconomyScore() const {
+    return getType().getEconomyScore();
+}
+
+FacilityCategory Facility::getCategory() const {
+    return getType().getCategory();
 }
 
 // Field's getters and setters
 const string &Facility::getSettlementName() const {
-    return settlementName;
+    return settlement->getName();
 }
 
 const int Facility::getTimeLeft() const {
@@ -88,9 +122,216 @@ FacilityStatus Facility::step() {
     return status;
 }
 
+// Updates the status of the facility by simulating several time steps at once
+FacilityStatus Facility::step(const int numOfSteps) {
+    if (status == FacilityStatus::UNDER_CONSTRUCTIONS && timeLeft > 0 && numOfSteps > 0) {
+        timeLeft = (numOfSteps < timeLeft) ? timeLeft - numOfSteps : 0;
+        if (timeLeft == 0) {
+            status = FacilityStatus::OPERATIONAL;
+        }
+    }
+    return status;
+}
+
 // Converts the facility's data to a readable string
 const string Facility::toString() const {
-    return "Facility: " + getName()  + ", Settlement: " + settlementName + 
+    return "Facility: " + getName()  + ", Settlement: " + getSettlementName() + 
            ", Status: " + (status == FacilityStatus::OPERATIONAL ? "Operational" : "Under Construction") + 
            ", Time Left: " + to_string(timeLeft);
-}
\ No newline at end of file
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ************************************************ FacilityPool ****************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Rule of 5 used here, but the pool can only be moved - Class owns the chunks.
+
+atomic<size_t> FacilityPool::createdFacilities(0);
+atomic<size_t> FacilityPool::chunkAllocations(0);
+
+// Constructor: no chunks until the first facility
+FacilityPool::FacilityPool(const size_t chunkSize) : chunkSize(max(chunkSize, size_t(1))), chunks(), freeSlots(), numOfFacilities(0) {}
+
+// Move Constructor
+FacilityPool::FacilityPool(FacilityPool &&other) noexcept
+    : chunkSize(other.chunkSize), chunks(move(other.chunks)), freeSlots(move(other.freeSlots)), numOfFacilities(other.numOfFacilities) {
+    other.chunks.clear();
+    other.freeSlots.clear();
+    other.numOfFacilities = 0;
+}
+
+// Destructor
+FacilityPool::~FacilityPool() {
+    clear();
+}
+
+// Builds a new facility of the given type in the pool
+Facility *FacilityPool::create(const vector<FacilityType> &facilityOptions, const int typeIndex, const Settlement &settlement) {
+    Facility *facility = new (allocate()) Facility(facilityOptions, typeIndex, settlement);
+    createdFacilities++;
+    return facility;
+}
+
+// Builds a copy of another facility in the pool
+Facility *FacilityPool::create(const Facility &other) {
+    Facility *facility = new (allocate()) Facility(other);
+    createdFacilities++;
+    return facility;
+}
+
+// Gives a facility's slot back to the pool, the facility must not be used anymore
+void FacilityPool::release(Facility *facility) {
+    freeSlots.push_back(facility);
+}
+
+// Releases every facility of the pool, a chunk at a time (Facility has nothing to destroy)
+void FacilityPool::clear() {
+    static_assert(is_trivially_destructible<Facility>::value, "Facility must not need its destructor");
+    for (Facility *chunk : chunks) {
+        ::operator delete(chunk);
+    }
+    chunks.clear();
+    freeSlots.clear();
+    numOfFacilities = 0;
+}
+
+// Number of facilities in the pool
+size_t FacilityPool::size() const {
+    return numOfFacilities - freeSlots.size();
+}
+
+// Bytes the pool holds on the heap
+size_t FacilityPool::getMemoryUsage() const {
+    return chunks.capacity() * sizeof(Facility*) + chunks.size() * chunkSize * sizeof(Facility) + freeSlots.capacity() * sizeof(Facility*);
+}
+
+// Number of facilities created by all the pools so far
+size_t FacilityPool::getNumOfCreatedFacilities() {
+    return createdFacilities;
+}
+
+// Number of times any pool went to the heap for a new chunk
+size_t FacilityPool::getNumOfChunkAllocations() {
+    return chunkAllocations;
+}
+
+// Returns raw storage for one more facility: a released slot if there is one,
+// otherwise the next slot of the last chunk, taking a new chunk only when that one is full
+Facility *FacilityPool::allocate() {
+    if (!freeSlots.empty()) {
+        Facility *slot = freeSlots.back();
+        freeSlots.pop_back();
+        return slot;
+    }
+    if (numOfFacilities == chunks.size() * chunkSize) {
+        chunks.push_back(static_cast<Facility*>(::operator new(chunkSize * sizeof(Facility))));
+        chunkAllocations++;
+    }
+    Facility *slot = chunks[numOfFacilities / chunkSize] + numOfFacilities % chunkSize;
+    numOfFacilities++;
+    return slot;
+}
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ********************************************** ConstructionQueue *************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// No rule of 3 needed - The facilities belong to the plan's pool, the queue only orders them.
+
+// Constructor
+ConstructionQueue::ConstructionQueue() : nodes(), head(-1), tail(-1), freeSlot(-1), numOfFacilities(0) {}
+
+// Adds a facility after the last one and returns its slot, which stays the same until it is erased
+int ConstructionQueue::push_back(Facility *facility) {
+    int slot;
+    if (freeSlot != -1) {
+        slot = freeSlot;
+        freeSlot = nodes[slot].next;
+    } else {
+        slot = static_cast<int>(nodes.size());
+        nodes.emplace_back();
+    }
+    nodes[slot] = {facility, tail, -1};
+    if (tail != -1) {
+        nodes[tail].next = slot;
+    } else {
+        head = slot;
+    }
+    tail = slot;
+    numOfFacilities++;
+    return slot;
+}
+
+// Removes the facility in the given slot, the rest keep their order
+void ConstructionQueue::erase(const int slot) {
+    Node &node = nodes[slot];
+    if (node.prev != -1) {
+        nodes[node.prev].next = node.next;
+    } else {
+        head = node.next;
+    }
+    if (node.next != -1) {
+        nodes[node.next].prev = node.prev;
+    } else {
+        tail = node.prev;
+    }
+    node = {nullptr, -1, freeSlot};
+    freeSlot = slot;
+    numOfFacilities--;
+}
+
+// The facility in the given slot
+Facility *ConstructionQueue::at(const int slot) const {
+    return nodes[slot].facility;
+}
+
+// Slot of the earliest facility, -1 if the queue is empty
+int ConstructionQueue::first() const {
+    return head;
+}
+
+// Slot of the facility that follows the given one, -1 after the last
+int ConstructionQueue::next(const int slot) const {
+    return nodes[slot].next;
+}
+
+size_t ConstructionQueue::size() const {
+    return numOfFacilities;
+}
+
+bool ConstructionQueue::empty() const {
+    return numOfFacilities == 0;
+}
+
+// Forgets every facility, the caller releases them
+void ConstructionQueue::clear() {
+    nodes.clear();
+    head = tail = freeSlot = -1;
+    numOfFacilities = 0;
+}
+
+// Iteration in construction order
+ConstructionQueue::const_iterator ConstructionQueue::begin() const {
+    return const_iterator(*this, head);
+}
+
+ConstructionQueue::const_iterator ConstructionQueue::end() const {
+    return const_iterator(*this, -1);
+}
+
+ConstructionQueue::const_iterator::const_iterator(const ConstructionQueue &queue, int slot) : queue(&queue), slot(slot) {}
+
+Facility *ConstructionQueue::const_iterator::operator*() const {
+    return queue->at(slot);
+}
+
+ConstructionQueue::const_iterator &ConstructionQueue::const_iterator::operator++() {
+    slot = queue->next(slot);
+    return *this;
+}
+
+bool ConstructionQueue::const_iterator::operator!=(const const_iterator &other) const {
+    return slot != other.slot;
+}
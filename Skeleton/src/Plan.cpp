@@ -9,9 +9,13 @@ Plan::Plan(const int planId, const Settlement &settlement, SelectionPolicy *sele
     : plan_id(planId),
       settlement(settlement),
       selectionPolicy(selectionPolicy),
+      policyType(getPolicyType(selectionPolicy)),
       status(PlanStatus::AVALIABLE),
+      facilityPool(getCapacity(settlement.getType())),
       facilities(),
       underConstruction(),
+      compact(false),
+      operationalCounts(),
       facilityOptions(facilityOptions),
       life_quality_score(0),
       economy_score(0),
@@ -24,23 +28,22 @@ Plan::Plan(const Plan &other)
     : plan_id(other.plan_id),
       settlement(other.settlement), // References the same settlement object.
       selectionPolicy(other.selectionPolicy->clone()), // Deep copy of selection policy.
+      policyType(other.policyType),
       status(other.status),
-      facilities(),
+      facilityPool(getCapacity(other.settlement.getType())),
+      facilities(other.facilities), // Shared until either plan completes a facility
       underConstruction(),
+      compact(other.compact),
+      operationalCounts(other.operationalCounts),
       facilityOptions(other.facilityOptions), // References the same facility options.
       life_quality_score(other.life_quality_score),
       economy_score(other.economy_score),
       environment_score(other.environment_score)
     {
 
-    // Deep copy facilities
-    for (Facility* facility : other.facilities) {
-        facilities.push_back(new Facility(*facility));
-    }
-
     // Deep copy under-construction facilities
     for (Facility* facility : other.underConstruction) {
-        underConstruction.push_back(new Facility(*facility));
+        underConstruction.push_back(facilityPool.create(*facility));
     }
 }
 
@@ -49,9 +52,13 @@ Plan::Plan(Plan &&other) noexcept
     : plan_id(other.plan_id),
       settlement(other.settlement),
       selectionPolicy(other.selectionPolicy),
+      policyType(other.policyType),
       status(other.status),
-      facilities(move(other.facilities)),   // Transfers ownership
-      underConstruction(move(other.underConstruction)),   // Transfers ownership
+      facilityPool(move(other.facilityPool)), // Transfers ownership, facilities stay where they are
+      facilities(move(other.facilities)),
+      underConstruction(move(other.underConstruction)),
+      compact(other.compact),
+      operationalCounts(move(other.operationalCounts)),
       facilityOptions(move(other.facilityOptions)), // References the same facility options.
       life_quality_score(other.life_quality_score),
       economy_score(other.economy_score),
@@ -61,15 +68,9 @@ Plan::Plan(Plan &&other) noexcept
     other.selectionPolicy = nullptr;
 }
 
-// Destructor
+// Destructor: the facilities under construction go away with their pool
 Plan::~Plan() {
     delete selectionPolicy; 
-    for (Facility *facility : facilities) {
-        delete facility;
-    }
-    for (Facility *facility : underConstruction) {
-        delete facility;
-    }
 }
 
 // Field's getters and setters
@@ -93,56 +94,317 @@ SelectionPolicy* Plan::getSelectionPolicy() const {
     return selectionPolicy;
 }
 
+PolicyType Plan::getPolicyType() const {
+    return policyType;
+}
+
 const Settlement& Plan::getSettlement() const {
     return settlement; 
 }
 
-const vector<Facility *> &Plan::getFacilities() const {
+const SharedVector<Facility> &Plan::getFacilities() const {
     return facilities;
 }
 
-const std::vector<Facility *> &Plan::getFacilitiesUnderConstruction() const {
+const ConstructionQueue &Plan::getFacilitiesUnderConstruction() const {
     return underConstruction;
 }
 
+// Number of operational facilities of each catalog type (compact mode only)
+const vector<long long> &Plan::getOperationalCounts() const {
+    return operationalCounts;
+}
+
+// Adds the bytes the plan holds outside of itself (see SharedVector::measure); the operational facilities may be shared
+void Plan::measure(const bool isUnique, size_t &uniqueBytes, size_t &totalBytes) const {
+    size_t ownBytes = facilityPool.getMemoryUsage() + operationalCounts.capacity() * sizeof(long long);
+    totalBytes += ownBytes;
+    uniqueBytes += isUnique ? ownBytes : 0;
+    facilities.measure(isUnique, uniqueBytes, totalBytes, [](const Facility &, bool, size_t &, size_t &) {});
+}
+
+// Writes the plan's state to an image: everything but its identity and policy, which the simulation writes
+void Plan::save(ImageWriter &writer) const {
+    writer.writeSize(static_cast<size_t>(status));
+    writer.writeInt(life_quality_score);
+    writer.writeInt(economy_score);
+    writer.writeInt(environment_score);
+    writer.writeSize(underConstruction.size());
+    for (const Facility *facility : underConstruction) {
+        writer.writeSize(static_cast<size_t>(facility->getTypeIndex()));
+        writer.writeInt(facility->getTimeLeft());
+    }
+    writer.writeSize(compact ? 1 : 0);
+    writer.writeSize(facilities.size());
+    for (const Facility &facility : facilities) {
+        writer.writeSize(static_cast<size_t>(facility.getTypeIndex()));
+    }
+    writer.writeSize(operationalCounts.size());
+    for (long long count : operationalCounts) {
+        writer.writeInt(count);
+    }
+}
+
+// Reads the state written by save() into a new plan
+void Plan::load(ImageReader &reader) {
+    status = static_cast<PlanStatus>(reader.readSize(static_cast<size_t>(PlanStatus::BUSY) + 1));
+    life_quality_score = reader.readInt();
+    economy_score = reader.readInt();
+    environment_score = reader.readInt();
+    for (size_t i = reader.readSize(getCapacity() + 1); i > 0; i--) {
+        Facility *facility = facilityPool.create(facilityOptions, static_cast<int>(reader.readSize(facilityOptions.size())), settlement);
+        underConstruction.push_back(facility);
+        // Still under construction: at least a step left, unless the type takes none (and stays under construction)
+        int timeLeft = reader.readInt();
+        if (timeLeft > facility->getTimeLeft() || (timeLeft < 1 && timeLeft != facility->getTimeLeft())) {
+            throw runtime_error("Invalid image");
+        }
+        facility->step(facility->getTimeLeft() - timeLeft);
+    }
+    compact = reader.readSize(2) == 1;
+    for (size_t i = reader.readSize(); i > 0; i--) {
+        Facility facility(facilityOptions, static_cast<int>(reader.readSize(facilityOptions.size())), settlement);
+        facility.step(facility.getTimeLeft());
+        facilities.push_back(facility);
+    }
+    operationalCounts.resize(reader.readSize(facilityOptions.size() + 1));
+    for (long long &count : operationalCounts) {
+        count = reader.readLong();
+        if (count < 0) {
+            throw runtime_error("Invalid image");
+        }
+    }
+}
+
+// Adds the bytes the plan holds outside of itself on top of other, an earlier or later copy of it (or null)
+void Plan::measureDifference(const Plan *other, size_t &bytes) const {
+    bytes += facilityPool.getMemoryUsage() + operationalCounts.capacity() * sizeof(long long);
+    facilities.measureDifference(other != nullptr ? other->facilities : SharedVector<Facility>(), bytes,
+                                 [](const Facility &, const Facility *, size_t &) {});
+}
+
+bool Plan::isCompact() const {
+    return compact;
+}
+
+// Switches between keeping every operational facility and only counting them per type.
+// Counting keeps the plan's memory bounded by the catalog size, however long it runs.
+void Plan::setCompact(const bool compact) {
+    if (compact && !this->compact) {
+        operationalCounts.assign(facilityOptions.size(), 0);
+        for (const Facility &facility : facilities) {
+            operationalCounts[facility.getTypeIndex()]++;
+        }
+        facilities.clear();
+    } else if (!compact && this->compact) {
+        // The completion order is lost, the facilities come back grouped by type
+        for (size_t i = 0; i < operationalCounts.size(); i++) {
+            for (long long j = 0; j < operationalCounts[i]; j++) {
+                Facility facility(facilityOptions, static_cast<int>(i), settlement);
+                facility.step(facility.getTimeLeft());
+                facilities.push_back(facility);
+            }
+        }
+        operationalCounts.clear();
+    }
+    this->compact = compact;
+}
+
 void Plan::setSelectionPolicy(SelectionPolicy *newSelectionPolicy) {
     if (selectionPolicy) {
         delete selectionPolicy;  // Clean up old policy
     }
     selectionPolicy = newSelectionPolicy; 
+    policyType = getPolicyType(newSelectionPolicy);
+}
+
+// The concrete type of a policy, looked up when a plan's policy is set rather than on every step
+PolicyType Plan::getPolicyType(const SelectionPolicy *selectionPolicy) {
+    if (dynamic_cast<const NaiveSelection*>(selectionPolicy)) return PolicyType::NAIVE;
+    if (dynamic_cast<const BalancedSelection*>(selectionPolicy)) return PolicyType::BALANCED;
+    if (dynamic_cast<const EconomySelection*>(selectionPolicy)) return PolicyType::ECONOMY;
+    if (dynamic_cast<const SustainabilitySelection*>(selectionPolicy)) return PolicyType::SUSTAINABILITY;
+    if (dynamic_cast<const OptimalSelection*>(selectionPolicy)) return PolicyType::OPTIMAL;
+    return PolicyType::OTHER;
+}
+
+// Takes over a state the plan was stepped to outside of its own objects (see PlanStateEngine):
+// the scores, the facilities still under construction in order with their timers,
+// and the types that were completed meanwhile, in completion order.
+void Plan::setState(const int lifeQualityScore, const int economyScore, const int environmentScore,
+                    const int *buildingTypes, const int *buildingTimers, const int numOfBuilding,
+                    const vector<int> &completedTypes) {
+    for (int typeIndex : completedTypes) {
+        Facility *facility = facilityPool.create(facilityOptions, typeIndex, settlement);
+        facility->step(facility->getTimeLeft());
+        completeFacility(facility);
+    }
+    life_quality_score = lifeQualityScore;
+    economy_score = economyScore;
+    environment_score = environmentScore;
+
+    for (Facility *facility : underConstruction) {
+        facilityPool.release(facility);
+    }
+    underConstruction.clear();
+    for (int i = 0; i < numOfBuilding; i++) {
+        Facility *facility = facilityPool.create(facilityOptions, buildingTypes[i], settlement);
+        facility->step(facility->getTimeLeft() - buildingTimers[i]);
+        underConstruction.push_back(facility);
+    }
+
+    if (underConstruction.size() == getCapacity()) {
+        status = PlanStatus::BUSY;
+    } else {
+        status = PlanStatus::AVALIABLE;
+    }
+}
+
+// Checks whether stepping can't fail, i.e. the policy always finds a facility to build.
+bool Plan::canStep() const {
+    return facilityOptions.empty() || selectionPolicy->canSelect(facilityOptions);
 }
 
 // Executes a single step of the plan, managing facility construction and scores.
 void Plan::step() {
-    size_t capacity;
-    // Determines the facility capacity based on the settlement type.
-    switch (settlement.getType()) {
-        case SettlementType::VILLAGE:    capacity = 1; break;
-        case SettlementType::CITY:       capacity = 2; break;
-        case SettlementType::METROPOLIS: capacity = 3; break;
-    }
+    size_t capacity = getCapacity();
     // Adds new facilities to under-construction if there's capacity and available options.
     while (capacity > underConstruction.size() && facilityOptions.size() != 0)  {  
-        FacilityType nextType = selectionPolicy->selectFacility(facilityOptions);
-        Facility* nextFacility = new Facility(nextType, settlement.getName());
+        const FacilityType &nextType = selectionPolicy->selectFacility(facilityOptions);
+        Facility* nextFacility = facilityPool.create(facilityOptions, static_cast<int>(&nextType - facilityOptions.data()), settlement);
         addFacility(nextFacility);
     }
     
     // Process under-construction facilities
-    for (size_t i = 0; i < underConstruction.size(); ) {
-        Facility *facility = underConstruction[i];
+    for (int slot = underConstruction.first(); slot != -1; ) {
+        Facility *facility = underConstruction.at(slot);
+        int next = underConstruction.next(slot);
         facility->step(); 
         if (facility->getStatus() == FacilityStatus::OPERATIONAL) {
-            addFacility(facility);
-            life_quality_score += facility->getLifeQualityScore();
-            economy_score += facility->getEconomyScore();
-            environment_score += facility->getEnvironmentScore();
-            underConstruction.erase(underConstruction.begin() + i); // Remove from under construction
+            underConstruction.erase(slot); // Remove from under construction
+            completeFacility(facility);
+        }
+        slot = next;
+    }
+
+    if (underConstruction.size() == capacity) {
+        status = PlanStatus::BUSY;
+    } else {
+        status = PlanStatus::AVALIABLE;
+    }
+}
+
+// Executes numOfSteps steps of the plan, jumping from one facility completion to the next.
+// In between the plan is full (or has nothing to build), so those steps would only count down timers.
+// With fastForward, a round-robin plan also watches for a step on which it is back in an earlier state:
+// from there on it repeats the same cycle, so whole cycles are applied at once instead of simulated.
+// Either way, gives exactly the same result as calling step() numOfSteps times.
+// The stepping loop is compiled once per policy type, so its selections are direct calls. The simulation steps
+// its plans by policy type through stepAs; this steps a single plan of any type.
+void Plan::step(const int numOfSteps, const bool fastForward) {
+    switch (policyType) {
+        case PolicyType::NAIVE: stepAs<NaiveSelection>(numOfSteps, fastForward); break;
+        case PolicyType::BALANCED: stepAs<BalancedSelection>(numOfSteps, fastForward); break;
+        case PolicyType::ECONOMY: stepAs<EconomySelection>(numOfSteps, fastForward); break;
+        case PolicyType::SUSTAINABILITY: stepAs<SustainabilitySelection>(numOfSteps, fastForward); break;
+        case PolicyType::OPTIMAL: stepAs<OptimalSelection>(numOfSteps, fastForward); break;
+        case PolicyType::OTHER: stepAs<SelectionPolicy>(numOfSteps, fastForward); break;
+    }
+}
+
+// step(numOfSteps, fastForward) for a plan whose policy is a Policy (see getPolicyType)
+template <class Policy>
+void Plan::stepAs(const int numOfSteps, const bool fastForward) {
+    stepWith(static_cast<Policy&>(*selectionPolicy), numOfSteps, fastForward);
+}
+
+template void Plan::stepAs<NaiveSelection>(const int numOfSteps, const bool fastForward);
+template void Plan::stepAs<BalancedSelection>(const int numOfSteps, const bool fastForward);
+template void Plan::stepAs<EconomySelection>(const int numOfSteps, const bool fastForward);
+template void Plan::stepAs<SustainabilitySelection>(const int numOfSteps, const bool fastForward);
+template void Plan::stepAs<OptimalSelection>(const int numOfSteps, const bool fastForward);
+template void Plan::stepAs<SelectionPolicy>(const int numOfSteps, const bool fastForward);
+
+// step(numOfSteps, fastForward) for a policy of a known type
+template <class Policy>
+void Plan::stepWith(Policy &policy, const int numOfSteps, const bool fastForward) {
+    size_t capacity = getCapacity();
+    vector<Completion> completions; // Min-heap by (step, order)
+    size_t order = 0;
+    for (int slot = underConstruction.first(); slot != -1; slot = underConstruction.next(slot)) {
+        Facility *facility = underConstruction.at(slot);
+        if (facility->getTimeLeft() > 0) {
+            completions.push_back({facility->getTimeLeft() - 1, order, 0, facility, slot});
+        }
+        order++;
+    }
+    make_heap(completions.begin(), completions.end(), isLater);
+
+    // States seen so far, valid only while the catalog and the policy stay as they are (i.e. during this call)
+    bool detectCycle = fastForward && policy.isRoundRobin();
+    map<vector<long long>, CycleMark> seenStates;
+    vector<int> completedTypes; // Types completed since detection started, in order
+    vector<int> selected;
+
+    long long now = 0;
+    while (now < numOfSteps) {
+        // Fill free capacity, as step() does
+        if (capacity > underConstruction.size() && facilityOptions.size() != 0) {
+            selected.clear();
+            policy.selectFacilities(facilityOptions, static_cast<int>(capacity - underConstruction.size()), selected);
+            for (int typeIndex : selected) {
+                Facility* nextFacility = facilityPool.create(facilityOptions, typeIndex, settlement);
+                int slot = underConstruction.push_back(nextFacility);
+                if (nextFacility->getTimeLeft() > 0) {
+                    completions.push_back({now + nextFacility->getTimeLeft() - 1, order, now, nextFacility, slot});
+                    push_heap(completions.begin(), completions.end(), isLater);
+                }
+                order++;
+            }
+        }
+
+        // Complete the facilities that finish on this step, in construction order
+        while (!completions.empty() && completions.front().step == now) {
+            Completion done = completions.front();
+            pop_heap(completions.begin(), completions.end(), isLater);
+            completions.pop_back();
+            done.facility->step(static_cast<int>(now - done.startStep + 1));
+            underConstruction.erase(done.slot);
+            if (detectCycle) {
+                completedTypes.push_back(done.facility->getTypeIndex());
+            }
+            completeFacility(done.facility);
+        }
+
+        if (detectCycle) {
+            vector<long long> state = getCycleState(completions, now);
+            auto seen = seenStates.find(state);
+            if (seen != seenStates.end()) {
+                long long period = now - seen->second.step;
+                long long numOfCycles = (numOfSteps - 1 - now) / period;
+                repeatCycle(seen->second, numOfCycles, numOfCycles * period, completedTypes, completions);
+                now += numOfCycles * period;
+                detectCycle = false; // Less than a cycle is left
+            } else if (seenStates.size() < maxCycleStates) {
+                seenStates[state] = {now, life_quality_score, economy_score, environment_score, completedTypes.size()};
+            } else {
+                detectCycle = false; // Not worth the memory, just keep stepping
+            }
+        }
+
+        // Skip to the next step on which something can change
+        if (capacity > underConstruction.size() && facilityOptions.size() != 0) {
+            now++;
         } else {
-            ++i;
+            now = completions.empty() ? numOfSteps : min(completions.front().step, static_cast<long long>(numOfSteps));
         }
     }
 
+    // Bring the timers of facilities still under construction up to date
+    for (const Completion &pending : completions) {
+        pending.facility->step(static_cast<int>(numOfSteps - pending.startStep));
+    }
+
     if (underConstruction.size() == capacity) {
         status = PlanStatus::BUSY;
     } else {
@@ -150,12 +412,100 @@ void Plan::step() {
     }
 }
 
-// Adds a facility to either the operational or under-construction list.
+// Everything that decides how a round-robin plan continues after the given step:
+// the policy's position and, in order, the type and remaining time of each facility under construction.
+vector<long long> Plan::getCycleState(const vector<Completion> &completions, const long long now) const {
+    vector<long long> state;
+    state.push_back(selectionPolicy->getLastSelectedIndex());
+    for (const Facility *facility : underConstruction) {
+        long long timeLeft = -1, typeIndex = -1; // Facilities that never complete only hold a place
+        for (const Completion &pending : completions) {
+            if (pending.facility == facility) {
+                timeLeft = pending.step - now;
+                typeIndex = facility->getTypeIndex();
+            }
+        }
+        state.push_back(timeLeft);
+        state.push_back(typeIndex);
+    }
+    return state;
+}
+
+// Applies numOfCycles more repetitions of the cycle that started at the given mark and ends now,
+// as if the plan had stepped through them. Pending completions move forward by the skipped steps.
+void Plan::repeatCycle(const CycleMark &start, const long long numOfCycles, const long long skippedSteps,
+                       const vector<int> &completedTypes, vector<Completion> &completions) {
+    if (numOfCycles <= 0) {
+        return;
+    }
+    life_quality_score += static_cast<int>(numOfCycles * (life_quality_score - start.lifeQualityScore));
+    economy_score += static_cast<int>(numOfCycles * (economy_score - start.economyScore));
+    environment_score += static_cast<int>(numOfCycles * (environment_score - start.environmentScore));
+
+    if (compact) {
+        for (size_t i = start.numOfCompletions; i < completedTypes.size(); i++) {
+            operationalCounts[completedTypes[i]] += numOfCycles;
+        }
+    } else {
+        size_t cycleEnd = facilities.size();
+        size_t cycleStart = cycleEnd - (completedTypes.size() - start.numOfCompletions);
+        for (long long i = 0; i < numOfCycles; i++) {
+            for (size_t j = cycleStart; j < cycleEnd; j++) {
+                facilities.push_back(facilities[j]);
+            }
+        }
+    }
+
+    for (Completion &pending : completions) {
+        pending.step += skippedSteps;
+        pending.startStep += skippedSteps;
+    }
+}
+
+// Orders completions so that the heap's front is the earliest one
+bool Plan::isLater(const Completion &a, const Completion &b) {
+    return a.step != b.step ? a.step > b.step : a.order > b.order;
+}
+
+// Determines the facility capacity based on the settlement type.
+size_t Plan::getCapacity() const {
+    return getCapacity(settlement.getType());
+}
+
+// Facility capacity of a plan in a settlement of the given type
+size_t Plan::getCapacity(const SettlementType settlementType) {
+    switch (settlementType) {
+        case SettlementType::VILLAGE:    return 1;
+        case SettlementType::CITY:       return 2;
+        case SettlementType::METROPOLIS: return 3;
+    }
+    return 0;
+}
+
+// Moves a facility that became operational to the operational list (or just counts it) and collects its scores.
+void Plan::completeFacility(Facility *facility) {
+    life_quality_score += facility->getLifeQualityScore();
+    economy_score += facility->getEconomyScore();
+    environment_score += facility->getEnvironmentScore();
+    if (compact) {
+        if (operationalCounts.size() < facilityOptions.size()) {
+            operationalCounts.resize(facilityOptions.size(), 0);
+        }
+        operationalCounts[facility->getTypeIndex()]++;
+        facilityPool.release(facility);
+    } else {
+        addFacility(facility);
+    }
+}
+
+// Adds a facility (owned by the plan's pool) to either the operational or under-construction list.
+// Operational facilities are kept by value, so the pool takes its slot back.
 void Plan::addFacility(Facility *facility) {
     if(facility->getStatus() == FacilityStatus::UNDER_CONSTRUCTIONS) {
         underConstruction.push_back(facility);
     } else {
-        facilities.push_back(facility);
+        facilities.push_back(*facility);
+        facilityPool.release(facility);
     }
 }
 
@@ -185,10 +535,19 @@ const string Plan::toString() const {
         output << "FacilityStatus: UNDER_CONSTRUCTION\n";
     }
 
-    for (const auto &facility : facilities) {
-        output << "FacilityName: " << facility->getName() << "\n";
+    for (const Facility &facility : facilities) {
+        output << "FacilityName: " << facility.getName() << "\n";
         output << "FacilityStatus: OPERATIONAL\n";
     }
 
+    // Compact plans list their operational facilities grouped by type
+    for (size_t i = 0; i < operationalCounts.size(); i++) {
+        if (operationalCounts[i] > 0) {
+            output << "FacilityName: " << facilityOptions[i].getName() << "\n";
+            output << "FacilityStatus: OPERATIONAL\n";
+            output << "FacilityCount: " << operationalCounts[i] << "\n";
+        }
+    }
+
     return output.str();
 }
@@ -0,0 +1,629 @@
+#include "PlanSolver.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cmath>
+#include <stdexcept>
+
+// Rule of 3 used here - The solver owns its thread pool, copies only take the settings.
+
+// What one solve chooses from
+struct PlanSolver::Problem {
+    Problem(const vector<FacilityType> &facilityOptions, const size_t capacity);
+    Problem(const Problem &other) = default;
+    Problem &operator=(const Problem &other) = default;
+    const vector<FacilityType> *facilityOptions;
+    size_t capacity;
+    long long horizonEnd; // Step the horizon ends on, set once the first selection's step is known
+    vector<int> candidates; // Catalog indices, ascending
+    // The objective is at most directions[k] . scores for every k (for the smallest score,
+    // any weights that add up to 1 will do), which is what the bounds are computed along
+    vector<array<double, 3>> directions;
+};
+
+// One solve's search. The slots of a plan don't interact - each is refilled the step it frees up -
+// so what a slot can still add depends only on how many steps it has left. Those outcomes are found once
+// per number of steps (the memo), keeping only the ones no other outcome beats on every score, and the
+// search then picks one outcome per slot, depth first, dropping branches that can't beat the best pick so far.
+class PlanSolver::Search {
+    public:
+        // The best pick among some of the first slot's outcomes
+        struct Result {
+            Result();
+            Value value;
+            vector<int> outcomes; // Per slot, its position in the slot's frontier
+            size_t numOfNodes;
+        };
+
+        Search(const PlanSolver &solver, const Problem &problem, const State &state);
+        long long getFirstStep() const;
+        int getNumOfFreeSlots() const;
+        void expand();
+        size_t getNumOfFirstOutcomes() const;
+        void combine(const size_t begin, const size_t end, const size_t maxNodes, Result &result) const;
+        void getSelections(const Result &result, vector<int> &selections) const;
+        void replay(const vector<int> &selections, State &state);
+        size_t getNumOfNodes() const;
+        size_t getNumOfMemoHits() const;
+
+    private:
+        // A busy slot: the facility in it and the step on which it frees up
+        struct Slot {
+            long long end;
+            int typeIndex;
+        };
+        // What a slot adds by building some sequence until the horizon: the scores of the facilities that
+        // complete in time, then of all the ones it starts. The sequence is its first facility (-1 for none)
+        // and the position of the rest in the frontier of the steps left after the first one.
+        struct Outcome {
+            long long scores[6];
+            int typeIndex;
+            int next;
+        };
+        // The outcomes of a slot with some number of steps left that no other outcome beats on all six scores,
+        // best first, with the most each direction's product can reach
+        struct Frontier {
+            Frontier();
+            vector<Outcome> outcomes;
+            vector<double> maxCompleted, maxCommitted;
+        };
+        static const long long neverEnds = LLONG_MAX;
+        const Frontier &getFrontier(const long long numOfSteps);
+        void combineFrom(const size_t slot, const size_t begin, const size_t end, long long scores[6],
+                         vector<int> &chosen, const size_t maxNodes, Result &result) const;
+        Value bound(const size_t slot, const long long scores[6]) const;
+        void addScores(const int typeIndex, long long scores[3], const int sign) const;
+
+        const PlanSolver &solver;
+        const Problem &problem;
+        long long completed[3]; // Scores of the operational facilities
+        long long committed[3]; // Including the facilities under construction
+        vector<Slot> busy;
+        long long firstStep;
+        int numOfFreeSlots;
+        long long baseScores[6]; // Completed within the horizon and committed, before any choice
+        vector<long long> slotStarts; // Step each slot frees up on before the horizon's end, ascending
+        vector<const Frontier*> slotFrontiers;
+        vector<vector<double>> remainingMaxCompleted, remainingMaxCommitted; // Per slot and direction, summed over the slots from there on
+        unordered_map<long long, Frontier> frontiers; // By number of steps left
+        size_t numOfNodes, numOfMemoHits;
+};
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ************************************************** PlanSolver ****************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const size_t PlanSolver::maxCandidates;
+const size_t PlanSolver::maxNodes;
+const size_t PlanSolver::maxFrontierSize;
+const size_t PlanSolver::numOfParts;
+
+// Problem constructor: no candidates yet
+PlanSolver::Problem::Problem(const vector<FacilityType> &facilityOptions, const size_t capacity)
+    : facilityOptions(&facilityOptions), capacity(capacity), horizonEnd(0), candidates(), directions() {}
+
+// State constructor: a plan that has built nothing yet
+PlanSolver::State::State() : lifeQualityScore(0), economyScore(0), environmentScore(0), building() {}
+
+// Constructor: looks 10 steps ahead for the largest smallest score
+PlanSolver::PlanSolver()
+    : horizon(10), objective(Objective::MIN_SCORE), weights{1, 1, 1}, numOfThreads(1), workers(nullptr), workersLock(),
+      numOfSolves(0), numOfNodes(0), numOfMemoHits(0), solveMicroseconds(0) {}
+
+// Copy Constructor
+PlanSolver::PlanSolver(const PlanSolver &other)
+    : horizon(other.horizon), objective(other.objective), weights{other.weights[0], other.weights[1], other.weights[2]},
+      numOfThreads(other.numOfThreads), workers(nullptr), workersLock(),
+      numOfSolves(0), numOfNodes(0), numOfMemoHits(0), solveMicroseconds(0) {}
+
+// Destructor
+PlanSolver::~PlanSolver() {
+    delete workers;
+}
+
+// How many steps each solve looks ahead
+void PlanSolver::setHorizon(const int horizon) {
+    if (horizon < 1) {
+        throw invalid_argument("Horizon must be positive");
+    }
+    this->horizon = horizon;
+}
+
+int PlanSolver::getHorizon() const {
+    return horizon;
+}
+
+// What the solves maximize (the weights only matter for WEIGHTED_SUM)
+void PlanSolver::setObjective(const Objective objective, const int lifeQualityWeight, const int economyWeight, const int environmentWeight) {
+    if (lifeQualityWeight < 0 || economyWeight < 0 || environmentWeight < 0) {
+        throw invalid_argument("Weights must not be negative");
+    }
+    this->objective = objective;
+    weights[0] = lifeQualityWeight;
+    weights[1] = economyWeight;
+    weights[2] = environmentWeight;
+}
+
+// How many threads a solve's parts run on (1 keeps every solve on the calling thread)
+void PlanSolver::setNumOfThreads(const int numOfThreads) {
+    if (numOfThreads < 1) {
+        throw invalid_argument("Number of threads must be positive");
+    }
+    lock_guard<mutex> guard(workersLock);
+    if (workers != nullptr && workers->size() != numOfThreads) {
+        delete workers;
+        workers = nullptr;
+    }
+    this->numOfThreads = numOfThreads;
+}
+
+// Appends to selections the best sequence for the horizon that starts at the plan's next free slot,
+// and moves state on to the end of that horizon, as if the plan had built the sequence.
+// facilityOptions must not be empty.
+void PlanSolver::solve(const vector<FacilityType> &facilityOptions, const size_t capacity, State &state, deque<int> &selections) const {
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    Problem problem = makeProblem(facilityOptions, capacity);
+    Search search(*this, problem, state);
+    if (search.getNumOfFreeSlots() == 0) return; // Every slot is blocked for good, nothing will be selected again
+    problem.horizonEnd = search.getFirstStep() + horizon;
+    search.expand();
+
+    // The first slot's outcomes are split into a fixed number of parts, searched independently
+    // (on the workers if they're free) so the result is the same however many threads run them
+    size_t numOfOutcomes = search.getNumOfFirstOutcomes();
+    size_t numOfSearches = min(numOfOutcomes, numOfParts);
+    vector<Search::Result> results(numOfSearches);
+    function<void(size_t)> searchPart = [&](size_t i) {
+        search.combine(numOfOutcomes * i / numOfSearches, numOfOutcomes * (i + 1) / numOfSearches, maxNodes / numOfSearches, results[i]);
+    };
+    unique_lock<mutex> guard(workersLock, try_to_lock);
+    if (numOfThreads > 1 && numOfSearches > 1 && guard.owns_lock()) {
+        if (workers == nullptr) {
+            workers = new ThreadPool(numOfThreads);
+        }
+        workers->run(numOfSearches, searchPart);
+    } else {
+        for (size_t i = 0; i < numOfSearches; i++) {
+            searchPart(i);
+        }
+    }
+    if (guard.owns_lock()) guard.unlock();
+
+    // Best value wins, ties go to the earlier part
+    size_t best = 0;
+    size_t solveNodes = search.getNumOfNodes();
+    for (size_t i = 0; i < numOfSearches; i++) {
+        if (results[best].value < results[i].value) {
+            best = i;
+        }
+        solveNodes += results[i].numOfNodes;
+    }
+    vector<int> sequence;
+    search.getSelections(results[best], sequence);
+    selections.insert(selections.end(), sequence.begin(), sequence.end());
+    Search replay(*this, problem, state);
+    replay.replay(sequence, state);
+
+    numOfSolves++;
+    numOfNodes += solveNodes;
+    numOfMemoHits += search.getNumOfMemoHits();
+    solveMicroseconds += chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - start).count();
+}
+
+// Instrumentation, over all solves so far
+size_t PlanSolver::getNumOfSolves() const {
+    return numOfSolves;
+}
+
+size_t PlanSolver::getNumOfNodes() const {
+    return numOfNodes;
+}
+
+size_t PlanSolver::getNumOfMemoHits() const {
+    return numOfMemoHits;
+}
+
+size_t PlanSolver::getSolveMicroseconds() const {
+    return solveMicroseconds;
+}
+
+// One of a type's three scores (0: life quality, 1: economy, 2: environment)
+int PlanSolver::getImpact(const FacilityType &type, const int score) {
+    switch (score) {
+        case 0: return type.getLifeQualityScore();
+        case 1: return type.getEconomyScore();
+        default: return type.getEnvironmentScore();
+    }
+}
+
+// The objective of a score vector
+long long PlanSolver::evaluate(const long long scores[3]) const {
+    if (objective == Objective::MIN_SCORE) {
+        return min({scores[0], scores[1], scores[2]});
+    }
+    return weights[0] * scores[0] + weights[1] * scores[1] + weights[2] * scores[2];
+}
+
+// Picks the facility types worth trying and the constants of the bounds
+PlanSolver::Problem PlanSolver::makeProblem(const vector<FacilityType> &facilityOptions, const size_t capacity) const {
+    Problem problem(facilityOptions, capacity);
+
+    // A type that costs nothing never completes and blocks its slot for good, so only if nothing else is there
+    vector<int> types;
+    for (size_t i = 0; i < facilityOptions.size(); i++) {
+        if (facilityOptions[i].getCost() > 0) {
+            types.push_back(static_cast<int>(i));
+        }
+    }
+    if (types.empty()) {
+        types.push_back(0);
+    }
+
+    // Large catalogs are cut down to the most efficient types for each score, and then for the objective
+    if (types.size() > maxCandidates) {
+        vector<int> kept;
+        for (int score = 0; score < 4 && kept.size() < maxCandidates; score++) {
+            // Score (or objective) per build step, higher first, then by catalog index
+            auto efficiency = [this, &facilityOptions, score](int type) {
+                if (score < 3) return static_cast<long long>(getImpact(facilityOptions[type], score));
+                long long impacts[3] = {facilityOptions[type].getLifeQualityScore(), facilityOptions[type].getEconomyScore(),
+                                        facilityOptions[type].getEnvironmentScore()};
+                return evaluate(impacts);
+            };
+            size_t quota = (score < 3) ? maxCandidates / 4 : maxCandidates - kept.size();
+            size_t numOfSorted = min(types.size(), maxCandidates);
+            partial_sort(types.begin(), types.begin() + numOfSorted, types.end(), [&](int a, int b) {
+                long long left = efficiency(a) * facilityOptions[b].getCost();
+                long long right = efficiency(b) * facilityOptions[a].getCost();
+                return left != right ? left > right : a < b;
+            });
+            for (size_t i = 0; i < numOfSorted && quota > 0; i++) {
+                if (find(kept.begin(), kept.end(), types[i]) == kept.end()) {
+                    kept.push_back(types[i]);
+                    quota--;
+                }
+            }
+        }
+        types = kept;
+    }
+
+    // With no negative scores, a type that costs no less and scores no more than another is never needed:
+    // the other one does at least as well in any slot of any sequence
+    bool hasNegativeImpacts = false;
+    for (int type : types) {
+        for (int score = 0; score < 3; score++) {
+            hasNegativeImpacts = hasNegativeImpacts || getImpact(facilityOptions[type], score) < 0;
+        }
+    }
+    for (int type : types) {
+        const FacilityType &candidate = facilityOptions[type];
+        bool isDominated = false;
+        for (int other : types) {
+            const FacilityType &rival = facilityOptions[other];
+            if (hasNegativeImpacts || other == type || rival.getCost() > candidate.getCost()) continue;
+            bool isAsGood = true, isBetter = rival.getCost() < candidate.getCost() || other < type;
+            for (int score = 0; score < 3; score++) {
+                isAsGood = isAsGood && getImpact(rival, score) >= getImpact(candidate, score);
+                isBetter = isBetter || getImpact(rival, score) > getImpact(candidate, score);
+            }
+            if (isAsGood && isBetter) {
+                isDominated = true;
+                break;
+            }
+        }
+        if (!isDominated) {
+            problem.candidates.push_back(type);
+        }
+    }
+    sort(problem.candidates.begin(), problem.candidates.end());
+
+    // The weighted sum is its own direction, the smallest score gets a grid of weights over the simplex
+    if (objective == Objective::WEIGHTED_SUM) {
+        problem.directions.push_back({{static_cast<double>(weights[0]), static_cast<double>(weights[1]), static_cast<double>(weights[2])}});
+    } else {
+        for (int first = 0; first <= numOfDirectionSteps; first++) {
+            for (int second = 0; first + second <= numOfDirectionSteps; second++) {
+                int third = numOfDirectionSteps - first - second;
+                problem.directions.push_back({{static_cast<double>(first) / numOfDirectionSteps, static_cast<double>(second) / numOfDirectionSteps,
+                                               static_cast<double>(third) / numOfDirectionSteps}});
+            }
+        }
+    }
+    return problem;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// *************************************************** Search ********************************************************* //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// No rule of 3 needed - The search borrows the solver and the problem for one solve.
+
+// Result constructor: nothing picked yet
+PlanSolver::Search::Result::Result() : value(LLONG_MIN, LLONG_MIN), outcomes(), numOfNodes(0) {}
+
+// Frontier constructor
+PlanSolver::Search::Frontier::Frontier() : outcomes(), maxCompleted(), maxCommitted() {}
+
+// Constructor: loads the plan's state and moves on to the first step with a free slot
+PlanSolver::Search::Search(const PlanSolver &solver, const Problem &problem, const State &state)
+    : solver(solver), problem(problem), completed{state.lifeQualityScore, state.economyScore, state.environmentScore},
+      committed{state.lifeQualityScore, state.economyScore, state.environmentScore}, busy(), firstStep(0), numOfFreeSlots(0),
+      baseScores(), slotStarts(), slotFrontiers(), remainingMaxCompleted(), remainingMaxCommitted(), frontiers(),
+      numOfNodes(0), numOfMemoHits(0) {
+    for (const Construction &construction : state.building) {
+        busy.push_back({construction.timeLeft > 0 ? construction.timeLeft : neverEnds, construction.typeIndex});
+        addScores(construction.typeIndex, committed, 1);
+    }
+    numOfFreeSlots = static_cast<int>(problem.capacity) - static_cast<int>(busy.size());
+    if (numOfFreeSlots > 0) return;
+
+    firstStep = neverEnds;
+    for (const Slot &slot : busy) {
+        firstStep = min(firstStep, slot.end);
+    }
+    if (firstStep == neverEnds) return;
+    for (size_t i = 0; i < busy.size();) {
+        if (busy[i].end == firstStep) {
+            addScores(busy[i].typeIndex, completed, 1);
+            busy.erase(busy.begin() + i);
+            numOfFreeSlots++;
+        } else {
+            i++;
+        }
+    }
+}
+
+// Step of the first selection
+long long PlanSolver::Search::getFirstStep() const {
+    return firstStep;
+}
+
+// Free slots on that step
+int PlanSolver::Search::getNumOfFreeSlots() const {
+    return numOfFreeSlots;
+}
+
+// Finds the outcomes of every slot that frees up before the horizon's end (the problem's horizon must be set)
+void PlanSolver::Search::expand() {
+    for (int score = 0; score < 3; score++) {
+        baseScores[score] = completed[score];
+        baseScores[3 + score] = committed[score];
+    }
+    slotStarts.assign(numOfFreeSlots, firstStep);
+    for (const Slot &slot : busy) {
+        if (slot.end <= problem.horizonEnd) {
+            addScores(slot.typeIndex, baseScores, 1);
+        }
+        if (slot.end < problem.horizonEnd) {
+            slotStarts.push_back(slot.end);
+        }
+    }
+    sort(slotStarts.begin(), slotStarts.end());
+    for (long long slotStart : slotStarts) {
+        slotFrontiers.push_back(&getFrontier(problem.horizonEnd - slotStart));
+    }
+
+    size_t numOfDirections = problem.directions.size();
+    remainingMaxCompleted.assign(slotStarts.size() + 1, vector<double>(numOfDirections, 0));
+    remainingMaxCommitted.assign(slotStarts.size() + 1, vector<double>(numOfDirections, 0));
+    for (size_t slot = slotStarts.size(); slot-- > 0;) {
+        for (size_t k = 0; k < numOfDirections; k++) {
+            remainingMaxCompleted[slot][k] = remainingMaxCompleted[slot + 1][k] + slotFrontiers[slot]->maxCompleted[k];
+            remainingMaxCommitted[slot][k] = remainingMaxCommitted[slot + 1][k] + slotFrontiers[slot]->maxCommitted[k];
+        }
+    }
+}
+
+// Number of outcomes of the first slot, to split the search by
+size_t PlanSolver::Search::getNumOfFirstOutcomes() const {
+    return slotFrontiers.front()->outcomes.size();
+}
+
+// The outcomes of a slot with numOfSteps steps left: it starts a candidate right away,
+// then goes on as a slot with that many fewer steps left if the candidate completes in time
+const PlanSolver::Search::Frontier &PlanSolver::Search::getFrontier(const long long numOfSteps) {
+    auto found = frontiers.find(numOfSteps);
+    if (found != frontiers.end()) {
+        numOfMemoHits++;
+        return found->second;
+    }
+
+    const vector<FacilityType> &facilityOptions = *problem.facilityOptions;
+    Frontier frontier;
+    if (numOfSteps == 0) {
+        frontier.outcomes.push_back({{0, 0, 0, 0, 0, 0}, -1, -1});
+    }
+    for (size_t position = 0; position < problem.candidates.size() && numOfSteps > 0; position++) {
+        int typeIndex = problem.candidates[position];
+        int price = facilityOptions[typeIndex].getCost();
+        Outcome first = {{0, 0, 0, 0, 0, 0}, typeIndex, -1};
+        addScores(typeIndex, first.scores + 3, 1);
+        if (price <= 0 || price > numOfSteps) {
+            frontier.outcomes.push_back(first);
+            continue;
+        }
+        addScores(typeIndex, first.scores, 1);
+        const Frontier &rest = getFrontier(numOfSteps - price);
+        for (size_t next = 0; next < rest.outcomes.size(); next++) {
+            Outcome outcome = first;
+            for (int score = 0; score < 6; score++) {
+                outcome.scores[score] += rest.outcomes[next].scores[score];
+            }
+            outcome.next = static_cast<int>(next);
+            frontier.outcomes.push_back(outcome);
+        }
+    }
+    numOfNodes += frontier.outcomes.size();
+
+    // Best first, then drop what an earlier outcome is at least as good as on every score
+    stable_sort(frontier.outcomes.begin(), frontier.outcomes.end(), [this](const Outcome &a, const Outcome &b) {
+        return Value(solver.evaluate(a.scores), solver.evaluate(a.scores + 3)) > Value(solver.evaluate(b.scores), solver.evaluate(b.scores + 3));
+    });
+    vector<Outcome> kept;
+    for (const Outcome &outcome : frontier.outcomes) {
+        bool isDominated = false;
+        for (const Outcome &other : kept) {
+            isDominated = true;
+            for (int score = 0; score < 6 && isDominated; score++) {
+                isDominated = other.scores[score] >= outcome.scores[score];
+            }
+            if (isDominated) break;
+        }
+        if (!isDominated) {
+            kept.push_back(outcome);
+            if (kept.size() == maxFrontierSize) break;
+        }
+    }
+    frontier.outcomes = move(kept);
+
+    for (const array<double, 3> &direction : problem.directions) {
+        double maxCompleted = -HUGE_VAL, maxCommitted = -HUGE_VAL;
+        for (const Outcome &outcome : frontier.outcomes) {
+            double completedProduct = 0, committedProduct = 0;
+            for (int score = 0; score < 3; score++) {
+                completedProduct += direction[score] * outcome.scores[score];
+                committedProduct += direction[score] * outcome.scores[3 + score];
+            }
+            maxCompleted = max(maxCompleted, completedProduct);
+            maxCommitted = max(maxCommitted, committedProduct);
+        }
+        frontier.maxCompleted.push_back(maxCompleted);
+        frontier.maxCommitted.push_back(maxCommitted);
+    }
+    return frontiers[numOfSteps] = move(frontier);
+}
+
+// Picks the best outcome per slot, with the first slot's taken from [begin, end), into result
+void PlanSolver::Search::combine(const size_t begin, const size_t end, const size_t maxNodes, Result &result) const {
+    long long scores[6];
+    copy(baseScores, baseScores + 6, scores);
+    vector<int> chosen;
+    combineFrom(0, begin, end, scores, chosen, maxNodes, result);
+}
+
+// Tries the outcomes [begin, end) for slot, on top of scores and the outcomes already chosen for the earlier slots.
+// Slots that free up on the same step are interchangeable, so their outcomes are only tried in one order.
+void PlanSolver::Search::combineFrom(const size_t slot, const size_t begin, const size_t end, long long scores[6],
+                                     vector<int> &chosen, const size_t maxNodes, Result &result) const {
+    if (slot == slotStarts.size()) {
+        Value value(solver.evaluate(scores), solver.evaluate(scores + 3));
+        if (result.value < value) {
+            result.value = value;
+            result.outcomes = chosen;
+        }
+        return;
+    }
+    if (!(result.value < bound(slot, scores))) return;
+
+    const vector<Outcome> &outcomes = slotFrontiers[slot]->outcomes;
+    for (size_t position = begin; position < end && result.numOfNodes < maxNodes; position++) {
+        result.numOfNodes++;
+        for (int score = 0; score < 6; score++) {
+            scores[score] += outcomes[position].scores[score];
+        }
+        chosen.push_back(static_cast<int>(position));
+        size_t nextBegin = (slot + 1 < slotStarts.size() && slotStarts[slot + 1] == slotStarts[slot]) ? position : 0;
+        size_t nextEnd = (slot + 1 < slotStarts.size()) ? slotFrontiers[slot + 1]->outcomes.size() : 0;
+        combineFrom(slot + 1, nextBegin, nextEnd, scores, chosen, maxNodes, result);
+        chosen.pop_back();
+        for (int score = 0; score < 6; score++) {
+            scores[score] -= outcomes[position].scores[score];
+        }
+    }
+}
+
+// No pick for the slots from slot on does better: along every direction, each slot adds at most its frontier's best
+PlanSolver::Value PlanSolver::Search::bound(const size_t slot, const long long scores[6]) const {
+    double completedBound = HUGE_VAL, committedBound = HUGE_VAL;
+    for (size_t k = 0; k < problem.directions.size(); k++) {
+        const array<double, 3> &direction = problem.directions[k];
+        double completedProduct = remainingMaxCompleted[slot][k], committedProduct = remainingMaxCommitted[slot][k];
+        for (int score = 0; score < 3; score++) {
+            completedProduct += direction[score] * scores[score];
+            committedProduct += direction[score] * scores[3 + score];
+        }
+        completedBound = min(completedBound, completedProduct);
+        committedBound = min(committedBound, committedProduct);
+    }
+    // Scores are whole numbers, the slack covers rounding in the products
+    return Value(static_cast<long long>(floor(completedBound + 1e-6)), static_cast<long long>(floor(committedBound + 1e-6)));
+}
+
+// The picked outcomes as one sequence, in the order the plan asks for them: by the step they start on
+void PlanSolver::Search::getSelections(const Result &result, vector<int> &selections) const {
+    const vector<FacilityType> &facilityOptions = *problem.facilityOptions;
+    vector<pair<long long, int>> starts;
+    for (size_t slot = 0; slot < result.outcomes.size(); slot++) {
+        long long step = slotStarts[slot];
+        const Outcome *outcome = &slotFrontiers[slot]->outcomes[result.outcomes[slot]];
+        while (outcome->typeIndex != -1) {
+            starts.push_back({step, outcome->typeIndex});
+            if (outcome->next == -1) break;
+            step += facilityOptions[outcome->typeIndex].getCost();
+            outcome = &frontiers.at(problem.horizonEnd - step).outcomes[outcome->next];
+        }
+    }
+    sort(starts.begin(), starts.end());
+    for (const pair<long long, int> &start : starts) {
+        selections.push_back(start.second);
+    }
+}
+
+// Builds selections in order from the search's state, and stores where that leaves the plan at the horizon's end
+void PlanSolver::Search::replay(const vector<int> &selections, State &state) {
+    const vector<FacilityType> &facilityOptions = *problem.facilityOptions;
+    long long step = firstStep;
+    int numOfFree = numOfFreeSlots;
+    size_t next = 0;
+    while (true) {
+        for (; numOfFree > 0 && next < selections.size(); numOfFree--) {
+            int price = facilityOptions[selections[next]].getCost();
+            busy.push_back({price > 0 ? step + price : neverEnds, selections[next]});
+            next++;
+        }
+        step = neverEnds;
+        for (const Slot &slot : busy) {
+            step = min(step, slot.end);
+        }
+        if (step >= problem.horizonEnd) break;
+        for (size_t i = 0; i < busy.size();) {
+            if (busy[i].end == step) {
+                addScores(busy[i].typeIndex, completed, 1);
+                busy.erase(busy.begin() + i);
+                numOfFree++;
+            } else {
+                i++;
+            }
+        }
+    }
+
+    state.building.clear();
+    for (const Slot &slot : busy) {
+        if (slot.end <= problem.horizonEnd) {
+            addScores(slot.typeIndex, completed, 1);
+        } else {
+            int timeLeft = slot.end == neverEnds ? 0 : static_cast<int>(slot.end - problem.horizonEnd);
+            state.building.push_back({slot.typeIndex, timeLeft});
+        }
+    }
+    state.lifeQualityScore = static_cast<int>(completed[0]);
+    state.economyScore = static_cast<int>(completed[1]);
+    state.environmentScore = static_cast<int>(completed[2]);
+}
+
+// Instrumentation of the outcomes' part of the search
+size_t PlanSolver::Search::getNumOfNodes() const {
+    return numOfNodes;
+}
+
+size_t PlanSolver::Search::getNumOfMemoHits() const {
+    return numOfMemoHits;
+}
+
+// Adds (sign 1) or takes away (sign -1) a type's scores
+void PlanSolver::Search::addScores(const int typeIndex, long long scores[3], const int sign) const {
+    const FacilityType &type = (*problem.facilityOptions)[typeIndex];
+    for (int score = 0; score < 3; score++) {
+        scores[score] += sign * static_cast<long long>(getImpact(type, score));
+    }
+}
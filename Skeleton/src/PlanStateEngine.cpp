@@ -0,0 +1,93 @@
+#include "PlanStateEngine.h"
+
+// No rule of 3 needed - The plans are only borrowed for one run.
+
+// Constructor: copies the catalog's numbers into columns
+PlanStateEngine::PlanStateEngine(const vector<FacilityType> &facilityOptions)
+    : facilityOptions(facilityOptions), prices(), lifeQualityImpacts(), economyImpacts(), environmentImpacts(),
+      plans(), capacities(), lifeQualityScores(), economyScores(), environmentScores(), numOfBuilding(),
+      firstSlot(), completedTypes(), slotTypes(), slotTimers() {
+    for (const FacilityType &type : facilityOptions) {
+        prices.push_back(type.getCost());
+        lifeQualityImpacts.push_back(type.getLifeQualityScore());
+        economyImpacts.push_back(type.getEconomyScore());
+        environmentImpacts.push_back(type.getEnvironmentScore());
+    }
+}
+
+// Appends a plan's current state to the arrays
+void PlanStateEngine::load(Plan &plan) {
+    plans.push_back(&plan);
+    capacities.push_back(static_cast<int>(plan.getCapacity()));
+    lifeQualityScores.push_back(plan.getlifeQualityScore());
+    economyScores.push_back(plan.getEconomyScore());
+    environmentScores.push_back(plan.getEnvironmentScore());
+    numOfBuilding.push_back(static_cast<int>(plan.getFacilitiesUnderConstruction().size()));
+    firstSlot.push_back(slotTypes.size());
+    completedTypes.emplace_back();
+
+    slotTypes.resize(slotTypes.size() + capacities.back(), -1);
+    slotTimers.resize(slotTimers.size() + capacities.back(), 0);
+    size_t slot = firstSlot.back();
+    for (const Facility *facility : plan.getFacilitiesUnderConstruction()) {
+        slotTypes[slot] = facility->getTypeIndex();
+        slotTimers[slot] = facility->getTimeLeft();
+        slot++;
+    }
+}
+
+// Number of loaded plans
+size_t PlanStateEngine::size() const {
+    return plans.size();
+}
+
+// Steps the loaded plans [begin, end) numOfSteps times, exactly as Plan::step() would.
+// Distinct ranges touch distinct elements, so they can run on different threads.
+void PlanStateEngine::step(const int numOfSteps, const size_t begin, const size_t end) {
+    vector<int> selected;
+    for (int i = 0; i < numOfSteps; i++) {
+        for (size_t plan = begin; plan < end; plan++) {
+            size_t slots = firstSlot[plan];
+            int building = numOfBuilding[plan];
+
+            // Fill free capacity through the plan's policy, all slots in one call
+            if (building < capacities[plan] && !facilityOptions.empty()) {
+                selected.clear();
+                plans[plan]->getSelectionPolicy()->selectFacilities(facilityOptions, capacities[plan] - building, selected);
+                for (int typeIndex : selected) {
+                    slotTypes[slots + building] = typeIndex;
+                    slotTimers[slots + building] = prices[typeIndex];
+                    building++;
+                }
+            }
+
+            // Count down and drop completed facilities, keeping the rest in construction order
+            int kept = 0;
+            for (int slot = 0; slot < building; slot++) {
+                int type = slotTypes[slots + slot];
+                int timer = slotTimers[slots + slot];
+                if (timer > 0 && --timer == 0) {
+                    lifeQualityScores[plan] += lifeQualityImpacts[type];
+                    economyScores[plan] += economyImpacts[type];
+                    environmentScores[plan] += environmentImpacts[type];
+                    completedTypes[plan].push_back(type);
+                    continue;
+                }
+                slotTypes[slots + kept] = type;
+                slotTimers[slots + kept] = timer;
+                kept++;
+            }
+            numOfBuilding[plan] = kept;
+        }
+    }
+}
+
+// Writes the stepped state back into the plans
+void PlanStateEngine::store() {
+    for (size_t plan = 0; plan < plans.size(); plan++) {
+        plans[plan]->setState(lifeQualityScores[plan], economyScores[plan], environmentScores[plan],
+                              &slotTypes[firstSlot[plan]], &slotTimers[firstSlot[plan]], numOfBuilding[plan],
+                              completedTypes[plan]);
+        completedTypes[plan].clear();
+    }
+}
@@ -0,0 +1,106 @@
+#include "PlanStorage.h"
+
+// No rule of 5 needed - The chunks and the plans in them are released by their last owner.
+
+// Constructor: no chunks until the first plan
+PlanStorage::PlanStorage() : plans() {}
+
+// Builds a new plan at the end of the storage
+Plan &PlanStorage::add(const int planId, const Settlement &settlement, SelectionPolicy *selectionPolicy, const vector<FacilityType> &facilityOptions) {
+    plans.emplace_back(planId, settlement, selectionPolicy, facilityOptions);
+    return back();
+}
+
+// Builds a copy of another plan at the end of the storage
+Plan &PlanStorage::add(const Plan &other) {
+    plans.push_back(other);
+    return back();
+}
+
+// Plan access by position, for changing it
+Plan &PlanStorage::operator[](size_t index) {
+    return plans.edit(index);
+}
+
+const Plan &PlanStorage::operator[](size_t index) const {
+    return plans[index];
+}
+
+Plan &PlanStorage::back() {
+    return (*this)[plans.size() - 1];
+}
+
+size_t PlanStorage::size() const {
+    return plans.size();
+}
+
+// Drops all the plans (the storages sharing them keep theirs)
+void PlanStorage::clear() {
+    plans.clear();
+}
+
+// Copies every chunk another storage shares, so plans can be changed from several threads without copying anything
+void PlanStorage::unshare() {
+    plans.unshare();
+}
+
+// Adds the bytes of the plans to totalBytes, and of those no other storage shares to uniqueBytes
+void PlanStorage::measure(size_t &uniqueBytes, size_t &totalBytes) const {
+    plans.measure(true, uniqueBytes, totalBytes, [](const Plan &plan, bool isUnique, size_t &uniqueBytes, size_t &totalBytes) {
+        plan.measure(isUnique, uniqueBytes, totalBytes);
+    });
+}
+
+// Adds the bytes of the plans that other doesn't share to bytes
+void PlanStorage::measureDifference(const PlanStorage &other, size_t &bytes) const {
+    plans.measureDifference(other.plans, bytes, [](const Plan &plan, const Plan *otherPlan, size_t &bytes) {
+        plan.measureDifference(otherPlan, bytes);
+    });
+}
+
+// Iteration in order of addition
+PlanStorage::iterator PlanStorage::begin() {
+    return iterator(*this, 0);
+}
+
+PlanStorage::iterator PlanStorage::end() {
+    return iterator(*this, plans.size());
+}
+
+PlanStorage::const_iterator PlanStorage::begin() const {
+    return const_iterator(*this, 0);
+}
+
+PlanStorage::const_iterator PlanStorage::end() const {
+    return const_iterator(*this, plans.size());
+}
+
+PlanStorage::iterator::iterator(PlanStorage &storage, size_t index) : storage(&storage), index(index) {}
+
+Plan &PlanStorage::iterator::operator*() const {
+    return (*storage)[index];
+}
+
+PlanStorage::iterator &PlanStorage::iterator::operator++() {
+    index++;
+    return *this;
+}
+
+bool PlanStorage::iterator::operator!=(const iterator &other) const {
+    return index != other.index;
+}
+
+PlanStorage::const_iterator::const_iterator(const PlanStorage &storage, size_t index) : storage(&storage), index(index) {}
+
+const Plan &PlanStorage::const_iterator::operator*() const {
+    return (*storage)[index];
+}
+
+PlanStorage::const_iterator &PlanStorage::const_iterator::operator++() {
+    index++;
+    return *this;
+}
+
+bool PlanStorage::const_iterator::operator!=(const const_iterator &other) const {
+    return index != other.index;
+}
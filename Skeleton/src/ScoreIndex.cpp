@@ -0,0 +1,376 @@
+#include "ScoreIndex.h"
+#include <algorithm>
+#include <climits>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SCORE_INDEX_X86
+#endif
+
+// Rule of 3 deleted - The remembered decisions are guarded by locks.
+// The catalog is only compared, never accessed through the index.
+
+// Constructor: built for no catalog yet
+ScoreIndex::ScoreIndex()
+    : catalog(nullptr), catalogSize(0), method(Method::AUTOMATIC), lifeQualityImpacts(), economyImpacts(), environmentImpacts(), points(), bounds(),
+      decisionShards(), cacheHits(0), cacheMisses(0) {}
+
+ScoreIndex::DecisionShard::DecisionShard() : lock(), decisions(), positions() {}
+
+// Rebuilds the tree if the catalog changed since the last build (types were added), or answers are to be found another way.
+// A forced method must be supported by the CPU (see isSupported). Must not run while plans are selecting through the index.
+void ScoreIndex::update(const vector<FacilityType> &facilityOptions, const Method method) {
+    if (catalog == facilityOptions.data() && catalogSize == facilityOptions.size() && this->method == method) {
+        return;
+    }
+    catalog = facilityOptions.data();
+    catalogSize = facilityOptions.size();
+    this->method = method;
+    clearDecisions(); // Made for the old catalog
+    lifeQualityImpacts.clear();
+    economyImpacts.clear();
+    environmentImpacts.clear();
+    points.clear();
+    bounds.clear();
+
+    for (const FacilityType &type : facilityOptions) {
+        lifeQualityImpacts.push_back(type.getLifeQualityScore());
+        economyImpacts.push_back(type.getEconomyScore());
+        environmentImpacts.push_back(type.getEnvironmentScore());
+    }
+    if (method == Method::AUTOMATIC ? catalogSize < minIndexedSize : method != Method::TREE) {
+        return;
+    }
+
+    for (size_t i = 0; i < catalogSize; i++) {
+        const FacilityType &type = facilityOptions[i];
+        points.push_back({static_cast<long long>(type.getLifeQualityScore()) - type.getEconomyScore(),
+                          static_cast<long long>(type.getEconomyScore()) - type.getEnvironmentScore(),
+                          static_cast<int>(i)});
+    }
+    bounds.resize(points.size());
+    build(0, points.size(), true);
+}
+
+// Forgets the catalog, so the next update builds the index again even for a catalog at the same address and of
+// the same size (one that was changed in place). Must not run while plans are selecting through the index.
+void ScoreIndex::clear() {
+    catalog = nullptr;
+    catalogSize = 0;
+    clearDecisions();
+}
+
+// Checks whether the index can answer for this catalog as it is now
+bool ScoreIndex::isBuiltFor(const vector<FacilityType> &facilityOptions) const {
+    return catalogSize != 0 && catalog == facilityOptions.data() && catalogSize == facilityOptions.size();
+}
+
+// Catalog index of the first type with the smallest range once added to the given scores.
+// Safe to call from several threads at once.
+int ScoreIndex::findMostBalanced(const int lifeQualityScore, const int economyScore, const int environmentScore) const {
+    if (catalogSize < minCachedSize) {
+        return computeMostBalanced(lifeQualityScore, economyScore, environmentScore);
+    }
+
+    Differences differences(static_cast<long long>(economyScore) - lifeQualityScore,
+                            static_cast<long long>(environmentScore) - economyScore);
+    DecisionShard &shard = decisionShards[DifferencesHash()(differences) % numOfDecisionShards];
+    {
+        lock_guard<mutex> guard(shard.lock);
+        auto position = shard.positions.find(differences);
+        if (position != shard.positions.end()) {
+            shard.decisions.splice(shard.decisions.begin(), shard.decisions, position->second);
+            cacheHits.fetch_add(1, memory_order_relaxed);
+            return position->second->second;
+        }
+    }
+    cacheMisses.fetch_add(1, memory_order_relaxed);
+
+    int index = computeMostBalanced(lifeQualityScore, economyScore, environmentScore);
+    lock_guard<mutex> guard(shard.lock);
+    if (shard.positions.count(differences) == 0) { // Another thread may have made the same decision meanwhile
+        shard.decisions.emplace_front(differences, index);
+        shard.positions[differences] = shard.decisions.begin();
+        if (shard.decisions.size() > maxDecisionsPerShard) {
+            shard.positions.erase(shard.decisions.back().first);
+            shard.decisions.pop_back();
+        }
+    }
+    return index;
+}
+
+// Number of decisions that were remembered, and that had to be made
+size_t ScoreIndex::getNumOfCacheHits() const {
+    return cacheHits.load();
+}
+
+size_t ScoreIndex::getNumOfCacheMisses() const {
+    return cacheMisses.load();
+}
+
+// Finds the most balanced type by a scan or through the tree
+int ScoreIndex::computeMostBalanced(const int lifeQualityScore, const int economyScore, const int environmentScore) const {
+    if (points.empty()) {
+        return scan(method, lifeQualityImpacts.data(), economyImpacts.data(), environmentImpacts.data(), catalogSize,
+                    lifeQualityScore, economyScore, environmentScore);
+    }
+    long long bestRange = -1;
+    int bestIndex = -1;
+    search(0, points.size(), true,
+           static_cast<long long>(economyScore) - lifeQualityScore,
+           static_cast<long long>(environmentScore) - economyScore,
+           bestRange, bestIndex);
+    return bestIndex;
+}
+
+// Forgets every remembered decision
+void ScoreIndex::clearDecisions() {
+    for (DecisionShard &shard : decisionShards) {
+        lock_guard<mutex> guard(shard.lock);
+        shard.decisions.clear();
+        shard.positions.clear();
+    }
+}
+
+size_t ScoreIndex::DifferencesHash::operator()(const Differences &differences) const {
+    return static_cast<size_t>(static_cast<unsigned long long>(differences.first) * 1000003ULL
+                               + static_cast<unsigned long long>(differences.second));
+}
+
+// Smallest absolute value in [low, high]
+long long ScoreIndex::distanceToZero(const long long low, const long long high) {
+    if (low > 0) return low;
+    if (high < 0) return -high;
+    return 0;
+}
+
+// Arranges points [begin, end) as a subtree split alternately on x and y, and computes its bounds
+void ScoreIndex::build(const size_t begin, const size_t end, const bool splitOnX) {
+    if (begin >= end) {
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    nth_element(points.begin() + begin, points.begin() + middle, points.begin() + end,
+                [splitOnX](const Point &a, const Point &b) { return splitOnX ? a.x < b.x : a.y < b.y; });
+
+    Bounds &box = bounds[middle];
+    box = {points[begin].x, points[begin].x, points[begin].y, points[begin].y, points[begin].index};
+    for (size_t i = begin + 1; i < end; i++) {
+        box.minX = min(box.minX, points[i].x);
+        box.maxX = max(box.maxX, points[i].x);
+        box.minY = min(box.minY, points[i].y);
+        box.maxY = max(box.maxY, points[i].y);
+        box.minIndex = min(box.minIndex, points[i].index);
+    }
+
+    build(begin, middle, !splitOnX);
+    build(middle + 1, end, !splitOnX);
+}
+
+// Improves (bestRange, bestIndex) with the points of the subtree over [begin, end).
+// A subtree is skipped when none of its points can beat the best one, counting first-index ties as a loss.
+void ScoreIndex::search(const size_t begin, const size_t end, const bool splitOnX, const long long queryX, const long long queryY,
+                        long long &bestRange, int &bestIndex) const {
+    if (begin >= end) {
+        return;
+    }
+    size_t middle = begin + (end - begin) / 2;
+    const Bounds &box = bounds[middle];
+    if (bestIndex != -1) {
+        long long lowU = box.minX - queryX, highU = box.maxX - queryX;
+        long long lowV = box.minY - queryY, highV = box.maxY - queryY;
+        long long lowerBound = max({distanceToZero(lowU, highU), distanceToZero(lowV, highV),
+                                    distanceToZero(lowU + lowV, highU + highV)});
+        if (lowerBound > bestRange || (lowerBound == bestRange && box.minIndex > bestIndex)) {
+            return;
+        }
+    }
+
+    const Point &point = points[middle];
+    long long u = point.x - queryX, v = point.y - queryY;
+    long long range = max({u < 0 ? -u : u, v < 0 ? -v : v, u + v < 0 ? -(u + v) : u + v});
+    if (bestIndex == -1 || range < bestRange || (range == bestRange && point.index < bestIndex)) {
+        bestRange = range;
+        bestIndex = point.index;
+    }
+
+    // The half on the query's side first, it is the likelier to hold the answer
+    bool queryFirst = splitOnX ? queryX < point.x : queryY < point.y;
+    if (queryFirst) {
+        search(begin, middle, !splitOnX, queryX, queryY, bestRange, bestIndex);
+        search(middle + 1, end, !splitOnX, queryX, queryY, bestRange, bestIndex);
+    } else {
+        search(middle + 1, end, !splitOnX, queryX, queryY, bestRange, bestIndex);
+        search(begin, middle, !splitOnX, queryX, queryY, bestRange, bestIndex);
+    }
+}
+
+// The scan kernels: first index with the smallest range, computed in int exactly like BalancedSelection's own loop
+namespace {
+
+typedef int (*ScanKernel)(const int *, const int *, const int *, const size_t, const int, const int, const int);
+
+int scanScalar(const int *lifeQualityImpacts, const int *economyImpacts, const int *environmentImpacts, const size_t size,
+               const int lifeQualityScore, const int economyScore, const int environmentScore) {
+    int bestIndex = -1;
+    int smallestRange = INT_MAX;
+    for (size_t i = 0; i < size; i++) {
+        int lifeQuality = lifeQualityImpacts[i] + lifeQualityScore;
+        int economy = economyImpacts[i] + economyScore;
+        int environment = environmentImpacts[i] + environmentScore;
+        int range = max({lifeQuality, economy, environment}) - min({lifeQuality, economy, environment});
+        if (range < smallestRange) {
+            smallestRange = range;
+            bestIndex = static_cast<int>(i);
+        }
+    }
+    return bestIndex;
+}
+
+#ifdef SCORE_INDEX_X86
+// Merges the per-lane winners (each lane keeps the first of its own smallest ranges),
+// then lets the scalar loop finish the types that don't fill a whole vector
+int finishScan(const int *laneRanges, const int *laneIndices, const int numOfLanes, const size_t scanned,
+               const int *lifeQualityImpacts, const int *economyImpacts, const int *environmentImpacts, const size_t size,
+               const int lifeQualityScore, const int economyScore, const int environmentScore) {
+    int bestIndex = -1;
+    int smallestRange = INT_MAX;
+    for (int lane = 0; lane < numOfLanes; lane++) {
+        if (laneIndices[lane] == -1) continue;
+        if (laneRanges[lane] < smallestRange || (laneRanges[lane] == smallestRange && laneIndices[lane] < bestIndex)) {
+            smallestRange = laneRanges[lane];
+            bestIndex = laneIndices[lane];
+        }
+    }
+    int tailIndex = scanScalar(lifeQualityImpacts + scanned, economyImpacts + scanned, environmentImpacts + scanned, size - scanned,
+                               lifeQualityScore, economyScore, environmentScore);
+    if (tailIndex != -1) {
+        size_t i = scanned + tailIndex;
+        int lifeQuality = lifeQualityImpacts[i] + lifeQualityScore;
+        int economy = economyImpacts[i] + economyScore;
+        int environment = environmentImpacts[i] + environmentScore;
+        int range = max({lifeQuality, economy, environment}) - min({lifeQuality, economy, environment});
+        if (range < smallestRange) {
+            bestIndex = static_cast<int>(i);
+        }
+    }
+    return bestIndex;
+}
+
+// 4 types at a time
+__attribute__((target("sse4.1")))
+int scanSse41(const int *lifeQualityImpacts, const int *economyImpacts, const int *environmentImpacts, const size_t size,
+              const int lifeQualityScore, const int economyScore, const int environmentScore) {
+    const __m128i lifeQualityOffset = _mm_set1_epi32(lifeQualityScore);
+    const __m128i economyOffset = _mm_set1_epi32(economyScore);
+    const __m128i environmentOffset = _mm_set1_epi32(environmentScore);
+    const __m128i step = _mm_set1_epi32(4);
+    __m128i indices = _mm_setr_epi32(0, 1, 2, 3);
+    __m128i bestRanges = _mm_set1_epi32(INT_MAX);
+    __m128i bestIndices = _mm_set1_epi32(-1);
+
+    size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        __m128i lifeQuality = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lifeQualityImpacts + i)), lifeQualityOffset);
+        __m128i economy = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(economyImpacts + i)), economyOffset);
+        __m128i environment = _mm_add_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i*>(environmentImpacts + i)), environmentOffset);
+        __m128i range = _mm_sub_epi32(_mm_max_epi32(_mm_max_epi32(lifeQuality, economy), environment),
+                                      _mm_min_epi32(_mm_min_epi32(lifeQuality, economy), environment));
+        __m128i better = _mm_cmpgt_epi32(bestRanges, range);
+        bestRanges = _mm_blendv_epi8(bestRanges, range, better);
+        bestIndices = _mm_blendv_epi8(bestIndices, indices, better);
+        indices = _mm_add_epi32(indices, step);
+    }
+
+    int laneRanges[4], laneIndices[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(laneRanges), bestRanges);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(laneIndices), bestIndices);
+    return finishScan(laneRanges, laneIndices, 4, i, lifeQualityImpacts, economyImpacts, environmentImpacts, size,
+                      lifeQualityScore, economyScore, environmentScore);
+}
+
+// 8 types at a time
+__attribute__((target("avx2")))
+int scanAvx2(const int *lifeQualityImpacts, const int *economyImpacts, const int *environmentImpacts, const size_t size,
+             const int lifeQualityScore, const int economyScore, const int environmentScore) {
+    const __m256i lifeQualityOffset = _mm256_set1_epi32(lifeQualityScore);
+    const __m256i economyOffset = _mm256_set1_epi32(economyScore);
+    const __m256i environmentOffset = _mm256_set1_epi32(environmentScore);
+    const __m256i step = _mm256_set1_epi32(8);
+    __m256i indices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    __m256i bestRanges = _mm256_set1_epi32(INT_MAX);
+    __m256i bestIndices = _mm256_set1_epi32(-1);
+
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        __m256i lifeQuality = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(lifeQualityImpacts + i)), lifeQualityOffset);
+        __m256i economy = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(economyImpacts + i)), economyOffset);
+        __m256i environment = _mm256_add_epi32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(environmentImpacts + i)), environmentOffset);
+        __m256i range = _mm256_sub_epi32(_mm256_max_epi32(_mm256_max_epi32(lifeQuality, economy), environment),
+                                         _mm256_min_epi32(_mm256_min_epi32(lifeQuality, economy), environment));
+        __m256i better = _mm256_cmpgt_epi32(bestRanges, range);
+        bestRanges = _mm256_blendv_epi8(bestRanges, range, better);
+        bestIndices = _mm256_blendv_epi8(bestIndices, indices, better);
+        indices = _mm256_add_epi32(indices, step);
+    }
+
+    int laneRanges[8], laneIndices[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(laneRanges), bestRanges);
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(laneIndices), bestIndices);
+    return finishScan(laneRanges, laneIndices, 8, i, lifeQualityImpacts, economyImpacts, environmentImpacts, size,
+                      lifeQualityScore, economyScore, environmentScore);
+}
+#endif
+
+// Whether the CPU running the simulation has the instructions of a kernel
+bool isAvx2Supported() {
+#ifdef SCORE_INDEX_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+bool isSse41Supported() {
+#ifdef SCORE_INDEX_X86
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("sse4.1");
+#else
+    return false;
+#endif
+}
+
+// Picked once, by what the CPU running the simulation supports
+ScanKernel chooseScanKernel() {
+#ifdef SCORE_INDEX_X86
+    if (isAvx2Supported()) return scanAvx2;
+    if (isSse41Supported()) return scanSse41;
+#endif
+    return scanScalar;
+}
+
+const ScanKernel scanKernel = chooseScanKernel();
+
+}
+
+// Whether answers can be found this way on the CPU running the simulation
+bool ScoreIndex::isSupported(const Method method) {
+    switch (method) {
+        case Method::SCAN_SSE41: return isSse41Supported();
+        case Method::SCAN_AVX2: return isAvx2Supported();
+        default: return true;
+    }
+}
+
+// First catalog index with the smallest range, scanning the score columns with the method's kernel
+// (the one picked for the CPU unless a scan is forced)
+int ScoreIndex::scan(const Method method, const int *lifeQualityImpacts, const int *economyImpacts, const int *environmentImpacts,
+                     const size_t size, const int lifeQualityScore, const int economyScore, const int environmentScore) {
+    ScanKernel kernel = scanKernel;
+#ifdef SCORE_INDEX_X86
+    if (method == Method::SCAN_SSE41) kernel = scanSse41;
+    if (method == Method::SCAN_AVX2) kernel = scanAvx2;
+#endif
+    if (method == Method::SCAN_SCALAR) kernel = scanScalar;
+    return kernel(lifeQualityImpacts, economyImpacts, environmentImpacts, size, lifeQualityScore, economyScore, environmentScore);
+}
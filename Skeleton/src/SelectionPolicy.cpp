@@ -2,6 +2,36 @@
 
 // No rule of 3 needed in any
 
+namespace {
+
+// Reads a catalog index a policy selected last, or -1 before its first selection
+int readSelectedIndex(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) {
+    int index = reader.readInt();
+    if (index < -1 || index >= static_cast<int>(facilitiesOptions.size())) {
+        throw runtime_error("Invalid image");
+    }
+    return index;
+}
+
+// Reads a catalog index a policy selected or plans to
+int readCatalogIndex(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) {
+    int index = readSelectedIndex(reader, facilitiesOptions);
+    if (index == -1) {
+        throw runtime_error("Invalid image");
+    }
+    return index;
+}
+
+// Reads a position among the catalog's types of a category, as the category index takes it
+size_t readCategoryPosition(ImageReader &reader, const vector<FacilityType>& facilitiesOptions, const FacilityCategory category) {
+    size_t numOfTypes = count_if(facilitiesOptions.begin(), facilitiesOptions.end(), [category](const FacilityType &type) {
+        return type.getCategory() == category;
+    });
+    return reader.readSize(max(numOfTypes, size_t(1))); // 0 before the first selection
+}
+
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ************************************************ NaiveSelection **************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -11,12 +41,38 @@ NaiveSelection::NaiveSelection() : lastSelectedIndex(-1) {}
 
 // Selects the next facility one by one
 const FacilityType& NaiveSelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
+    return facilitiesOptions[selectIndex(facilitiesOptions)];
+}
+
+// Selects the next numOfFacilities facilities at once, appending their catalog indices in order
+void NaiveSelection::selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) {
+    for (int i = 0; i < numOfFacilities; i++) {
+        selected.push_back(selectIndex(facilitiesOptions));
+    }
+}
+
+// Catalog index of the next facility
+int NaiveSelection::selectIndex(const vector<FacilityType>& facilitiesOptions) {
     if (facilitiesOptions.empty()) {
         throw runtime_error("No facilities available to select");
     }
 
     lastSelectedIndex = (lastSelectedIndex + 1) % facilitiesOptions.size();
-    return facilitiesOptions[lastSelectedIndex];
+    return lastSelectedIndex;
+}
+
+// Any facility will do
+bool NaiveSelection::canSelect(const vector<FacilityType>& facilitiesOptions) const {
+    return !facilitiesOptions.empty();
+}
+
+// Picks are fully determined by the last selected index
+bool NaiveSelection::isRoundRobin() const {
+    return true;
+}
+
+int NaiveSelection::getLastSelectedIndex() const {
+    return lastSelectedIndex;
 }
 
 // Returns the string representation of NaiveSelection
@@ -29,41 +85,84 @@ NaiveSelection* NaiveSelection::clone() const {
     return new NaiveSelection(*this);
 }
 
+// Writes the policy's state to an image
+void NaiveSelection::save(ImageWriter &writer) const {
+    writer.writeInt(lastSelectedIndex);
+}
+
+// Reads the state written by save()
+void NaiveSelection::load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) {
+    lastSelectedIndex = readSelectedIndex(reader, facilitiesOptions);
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ********************************************** BalancedSelection *************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Constructor: Initializes BalancedSelection with current scores
-BalancedSelection::BalancedSelection(int lifeQualityScore, int economyScore, int environmentScore)
-    : LifeQualityScore(lifeQualityScore), EconomyScore(economyScore), EnvironmentScore(environmentScore) {}
+BalancedSelection::BalancedSelection(int lifeQualityScore, int economyScore, int environmentScore, const ScoreIndex *scoreIndex)
+    : LifeQualityScore(lifeQualityScore), EconomyScore(economyScore), EnvironmentScore(environmentScore), scoreIndex(scoreIndex) {}
 
 // Selects the facility with the most balanced scores (smallest range between scores)
 const FacilityType& BalancedSelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
-    const FacilityType* bestFacility = nullptr;
+    return facilitiesOptions[selectIndex(facilitiesOptions)];
+}
+
+// Selects the next numOfFacilities facilities at once, appending their catalog indices in order
+void BalancedSelection::selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) {
+    for (int i = 0; i < numOfFacilities; i++) {
+        selected.push_back(selectIndex(facilitiesOptions));
+    }
+}
+
+// Catalog index of the most balanced facility, whose scores are then added to the accumulated ones
+int BalancedSelection::selectIndex(const vector<FacilityType>& facilitiesOptions) {
+    int bestIndex = -1;
     int smallestRange = INT_MAX; 
 
-    for (const auto& facility : facilitiesOptions) {
-        int adjustedLifeQuality = facility.getLifeQualityScore() + LifeQualityScore;
-        int adjustedEconomy = facility.getEconomyScore() + EconomyScore;
-        int adjustedEnvironment = facility.getEnvironmentScore() + EnvironmentScore;
-
-        // Calculate the range between max and min scores
-        int maxScore = max({adjustedLifeQuality, adjustedEconomy, adjustedEnvironment});
-        int minScore = min({adjustedLifeQuality, adjustedEconomy, adjustedEnvironment});
-        int range = maxScore - minScore;
-
-        if (range < smallestRange) {
-            smallestRange = range;
-            bestFacility = &facility;
+    // The index gives the same answer as the scan, ties included
+    if (scoreIndex && scoreIndex->isBuiltFor(facilitiesOptions)) {
+        bestIndex = scoreIndex->findMostBalanced(LifeQualityScore, EconomyScore, EnvironmentScore);
+    } else {
+        for (size_t i = 0; i < facilitiesOptions.size(); i++) {
+            const FacilityType &facility = facilitiesOptions[i];
+            int adjustedLifeQuality = facility.getLifeQualityScore() + LifeQualityScore;
+            int adjustedEconomy = facility.getEconomyScore() + EconomyScore;
+            int adjustedEnvironment = facility.getEnvironmentScore() + EnvironmentScore;
+
+            // Calculate the range between max and min scores
+            int maxScore = max({adjustedLifeQuality, adjustedEconomy, adjustedEnvironment});
+            int minScore = min({adjustedLifeQuality, adjustedEconomy, adjustedEnvironment});
+            int range = maxScore - minScore;
+
+            if (range < smallestRange) {
+                smallestRange = range;
+                bestIndex = static_cast<int>(i);
+            }
         }
     }
     
     // Update the accumulated scores
-    LifeQualityScore += bestFacility->getLifeQualityScore();
-    EconomyScore += bestFacility->getEconomyScore();
-    EnvironmentScore += bestFacility->getEnvironmentScore();
+    const FacilityType &bestFacility = facilitiesOptions[bestIndex];
+    LifeQualityScore += bestFacility.getLifeQualityScore();
+    EconomyScore += bestFacility.getEconomyScore();
+    EnvironmentScore += bestFacility.getEnvironmentScore();
+
+    return bestIndex;
+}
+
+// Any facility will do
+bool BalancedSelection::canSelect(const vector<FacilityType>& facilitiesOptions) const {
+    return !facilitiesOptions.empty();
+}
+
+// Picks depend on the accumulated scores, which keep growing
+bool BalancedSelection::isRoundRobin() const {
+    return false;
+}
 
-    return *bestFacility;
+int BalancedSelection::getLastSelectedIndex() const {
+    return -1;
 }
 
 // Returns the string representation of BalancedSelection
@@ -76,26 +175,88 @@ BalancedSelection* BalancedSelection::clone() const {
     return new BalancedSelection(*this);
 }
 
+// Writes the policy's state to an image
+void BalancedSelection::save(ImageWriter &writer) const {
+    writer.writeInt(LifeQualityScore);
+    writer.writeInt(EconomyScore);
+    writer.writeInt(EnvironmentScore);
+}
+
+// Reads the state written by save()
+void BalancedSelection::load(ImageReader &reader, const vector<FacilityType>&) {
+    LifeQualityScore = reader.readInt();
+    EconomyScore = reader.readInt();
+    EnvironmentScore = reader.readInt();
+}
+
+// Points the policy at the index of the catalog it selects from (null to always scan)
+void BalancedSelection::setScoreIndex(const ScoreIndex *scoreIndex) {
+    this->scoreIndex = scoreIndex;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ********************************************** EconomySelection **************************************************** //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Constructor: Initializes EconomySelection with no previous selection
-EconomySelection::EconomySelection() : lastSelectedIndex(-1) {}
+EconomySelection::EconomySelection(const CategoryIndex *categoryIndex)
+    : lastSelectedIndex(-1), lastSelectedPosition(0), categoryIndex(categoryIndex) {}
 
 // Selects the next facility with an ECONOMY category
 const FacilityType& EconomySelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
-    for (size_t i = 1; i <= facilitiesOptions.size(); i++) {
-        size_t curr = (lastSelectedIndex + i) % facilitiesOptions.size(); 
-        if (FacilityCategory::ECONOMY == facilitiesOptions[curr].getCategory()) {
-            lastSelectedIndex = curr; 
-            return facilitiesOptions[curr]; 
+    return facilitiesOptions[selectIndex(facilitiesOptions)];
+}
+
+// Selects the next numOfFacilities facilities at once, appending their catalog indices in order
+void EconomySelection::selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) {
+    for (int i = 0; i < numOfFacilities; i++) {
+        selected.push_back(selectIndex(facilitiesOptions));
+    }
+}
+
+// Catalog index of the next facility with an ECONOMY category
+int EconomySelection::selectIndex(const vector<FacilityType>& facilitiesOptions) {
+    if (categoryIndex && categoryIndex->isBuiltFor(facilitiesOptions)) {
+        int next = categoryIndex->findNext(FacilityCategory::ECONOMY, lastSelectedIndex, lastSelectedPosition);
+        if (next != -1) {
+            lastSelectedIndex = next;
+            return next;
+        }
+    } else {
+        for (size_t i = 1; i <= facilitiesOptions.size(); i++) {
+            size_t curr = (lastSelectedIndex + i) % facilitiesOptions.size(); 
+            if (FacilityCategory::ECONOMY == facilitiesOptions[curr].getCategory()) {
+                lastSelectedIndex = curr; 
+                return lastSelectedIndex; 
+            }
         }
     }
     throw runtime_error("No suitable facility found for EconomySelection");
 }
 
+// Checks whether there is a facility with an ECONOMY category to select
+bool EconomySelection::canSelect(const vector<FacilityType>& facilitiesOptions) const {
+    if (categoryIndex && categoryIndex->isBuiltFor(facilitiesOptions)) {
+        return categoryIndex->hasCategory(FacilityCategory::ECONOMY);
+    }
+    for (const auto& facility : facilitiesOptions) {
+        if (FacilityCategory::ECONOMY == facility.getCategory()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Picks are fully determined by the last selected index
+bool EconomySelection::isRoundRobin() const {
+    return true;
+}
+
+int EconomySelection::getLastSelectedIndex() const {
+    return lastSelectedIndex;
+}
+
 // Returns the string representation of EconomySelection
 const string EconomySelection::toString() const {
     return "eco";
@@ -106,26 +267,86 @@ EconomySelection* EconomySelection::clone() const {
     return new EconomySelection(*this);
 }
 
+// Writes the policy's state to an image
+void EconomySelection::save(ImageWriter &writer) const {
+    writer.writeInt(lastSelectedIndex);
+    writer.writeSize(lastSelectedPosition);
+}
+
+// Reads the state written by save()
+void EconomySelection::load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) {
+    lastSelectedIndex = readSelectedIndex(reader, facilitiesOptions);
+    lastSelectedPosition = readCategoryPosition(reader, facilitiesOptions, FacilityCategory::ECONOMY);
+}
+
+// Points the policy at the index of the catalog it selects from (null to always scan)
+void EconomySelection::setCategoryIndex(const CategoryIndex *categoryIndex) {
+    this->categoryIndex = categoryIndex;
+}
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // ******************************************* SustainabilitySelection ************************************************ //
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
 // Constructor: Initializes SustainabilitySelection with no previous selection
-SustainabilitySelection::SustainabilitySelection() : lastSelectedIndex(-1) {}
+SustainabilitySelection::SustainabilitySelection(const CategoryIndex *categoryIndex)
+    : lastSelectedIndex(-1), lastSelectedPosition(0), categoryIndex(categoryIndex) {}
 
 // Selects the next facility with an ENVIRONMENT category
 const FacilityType& SustainabilitySelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
-    for (size_t i = 1; i <= facilitiesOptions.size(); i++) {
-        size_t curr = (lastSelectedIndex + i) % facilitiesOptions.size(); 
-        if (FacilityCategory::ENVIRONMENT == facilitiesOptions[curr].getCategory()) {
-            lastSelectedIndex = curr; 
-            return facilitiesOptions[curr]; 
+    return facilitiesOptions[selectIndex(facilitiesOptions)];
+}
+
+// Selects the next numOfFacilities facilities at once, appending their catalog indices in order
+void SustainabilitySelection::selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) {
+    for (int i = 0; i < numOfFacilities; i++) {
+        selected.push_back(selectIndex(facilitiesOptions));
+    }
+}
+
+// Catalog index of the next facility with an ENVIRONMENT category
+int SustainabilitySelection::selectIndex(const vector<FacilityType>& facilitiesOptions) {
+    if (categoryIndex && categoryIndex->isBuiltFor(facilitiesOptions)) {
+        int next = categoryIndex->findNext(FacilityCategory::ENVIRONMENT, lastSelectedIndex, lastSelectedPosition);
+        if (next != -1) {
+            lastSelectedIndex = next;
+            return next;
+        }
+    } else {
+        for (size_t i = 1; i <= facilitiesOptions.size(); i++) {
+            size_t curr = (lastSelectedIndex + i) % facilitiesOptions.size(); 
+            if (FacilityCategory::ENVIRONMENT == facilitiesOptions[curr].getCategory()) {
+                lastSelectedIndex = curr; 
+                return lastSelectedIndex; 
+            }
         }
     }
     throw runtime_error("No suitable facility found for SustainabilitySelection");
 }
 
+// Checks whether there is a facility with an ENVIRONMENT category to select
+bool SustainabilitySelection::canSelect(const vector<FacilityType>& facilitiesOptions) const {
+    if (categoryIndex && categoryIndex->isBuiltFor(facilitiesOptions)) {
+        return categoryIndex->hasCategory(FacilityCategory::ENVIRONMENT);
+    }
+    for (const auto& facility : facilitiesOptions) {
+        if (FacilityCategory::ENVIRONMENT == facility.getCategory()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Picks are fully determined by the last selected index
+bool SustainabilitySelection::isRoundRobin() const {
+    return true;
+}
+
+int SustainabilitySelection::getLastSelectedIndex() const {
+    return lastSelectedIndex;
+}
+
 // Returns the string representation of SustainabilitySelection
 const string SustainabilitySelection::toString() const {
     return "sus";
@@ -134,4 +355,127 @@ const string SustainabilitySelection::toString() const {
 // Clone
 SustainabilitySelection* SustainabilitySelection::clone() const {
     return new SustainabilitySelection(*this);
-}
\ No newline at end of file
+}
+
+// Writes the policy's state to an image
+void SustainabilitySelection::save(ImageWriter &writer) const {
+    writer.writeInt(lastSelectedIndex);
+    writer.writeSize(lastSelectedPosition);
+}
+
+// Reads the state written by save()
+void SustainabilitySelection::load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) {
+    lastSelectedIndex = readSelectedIndex(reader, facilitiesOptions);
+    lastSelectedPosition = readCategoryPosition(reader, facilitiesOptions, FacilityCategory::ENVIRONMENT);
+}
+
+// Points the policy at the index of the catalog it selects from (null to always scan)
+void SustainabilitySelection::setCategoryIndex(const CategoryIndex *categoryIndex) {
+    this->categoryIndex = categoryIndex;
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// *********************************************** OptimalSelection *************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Constructor: for a plan with the given capacity, standing where state says
+OptimalSelection::OptimalSelection(const size_t capacity, const PlanSolver *planSolver, const PlanSolver::State &state)
+    : capacity(capacity), state(state), plannedSelections(), lastSelectedIndex(-1), planSolver(planSolver) {}
+
+// Selects the next facility of the planned sequence
+const FacilityType& OptimalSelection::selectFacility(const vector<FacilityType>& facilitiesOptions) {
+    return facilitiesOptions[selectIndex(facilitiesOptions)];
+}
+
+// Selects the next numOfFacilities facilities at once, appending their catalog indices in order
+void OptimalSelection::selectFacilities(const vector<FacilityType>& facilitiesOptions, const int numOfFacilities, vector<int>& selected) {
+    for (int i = 0; i < numOfFacilities; i++) {
+        selected.push_back(selectIndex(facilitiesOptions));
+    }
+}
+
+// Catalog index of the next planned facility, planning the next horizon when the plan is used up
+int OptimalSelection::selectIndex(const vector<FacilityType>& facilitiesOptions) {
+    if (facilitiesOptions.empty()) {
+        throw runtime_error("No facilities available to select");
+    }
+    if (plannedSelections.empty()) {
+        planSolver->solve(facilitiesOptions, capacity, state, plannedSelections);
+    }
+    if (plannedSelections.empty()) {
+        throw runtime_error("No suitable facility found for OptimalSelection");
+    }
+    lastSelectedIndex = plannedSelections.front();
+    plannedSelections.pop_front();
+    return lastSelectedIndex;
+}
+
+// Any facility will do
+bool OptimalSelection::canSelect(const vector<FacilityType>& facilitiesOptions) const {
+    return !facilitiesOptions.empty();
+}
+
+// Picks depend on the scores and timers, which keep changing
+bool OptimalSelection::isRoundRobin() const {
+    return false;
+}
+
+int OptimalSelection::getLastSelectedIndex() const {
+    return lastSelectedIndex;
+}
+
+// Returns the string representation of OptimalSelection
+const string OptimalSelection::toString() const {
+    return "opt";
+}
+
+// Clone
+OptimalSelection* OptimalSelection::clone() const {
+    return new OptimalSelection(*this);
+}
+
+// Writes the policy's state to an image: where the plan will stand and the selections planned to get there
+void OptimalSelection::save(ImageWriter &writer) const {
+    writer.writeSize(capacity);
+    writer.writeInt(state.lifeQualityScore);
+    writer.writeInt(state.economyScore);
+    writer.writeInt(state.environmentScore);
+    writer.writeSize(state.building.size());
+    for (const PlanSolver::Construction &construction : state.building) {
+        writer.writeInt(construction.typeIndex);
+        writer.writeInt(construction.timeLeft);
+    }
+    writer.writeSize(plannedSelections.size());
+    for (int typeIndex : plannedSelections) {
+        writer.writeInt(typeIndex);
+    }
+    writer.writeInt(lastSelectedIndex);
+}
+
+// Reads the state written by save(). The capacity is the plan's, which the policy was built with.
+void OptimalSelection::load(ImageReader &reader, const vector<FacilityType>& facilitiesOptions) {
+    if (reader.readSize() != capacity) {
+        throw runtime_error("Invalid image");
+    }
+    state.lifeQualityScore = reader.readInt();
+    state.economyScore = reader.readInt();
+    state.environmentScore = reader.readInt();
+    state.building.resize(reader.readSize(capacity + 1));
+    for (PlanSolver::Construction &construction : state.building) {
+        construction.typeIndex = readCatalogIndex(reader, facilitiesOptions);
+        construction.timeLeft = reader.readInt();
+        if (construction.timeLeft < 0 || construction.timeLeft > facilitiesOptions[construction.typeIndex].getCost()) {
+            throw runtime_error("Invalid image");
+        }
+    }
+    plannedSelections.clear();
+    for (size_t i = reader.readSize(); i > 0; i--) {
+        plannedSelections.push_back(readCatalogIndex(reader, facilitiesOptions));
+    }
+    lastSelectedIndex = readSelectedIndex(reader, facilitiesOptions);
+}
+
+// Points the policy at the solver that plans its sequences
+void OptimalSelection::setPlanSolver(const PlanSolver *planSolver) {
+    this->planSolver = planSolver;
+}
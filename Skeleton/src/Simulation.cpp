@@ -1,11 +1,11 @@
 #include "Simulation.h"
 #include "Action.h"
 
-// Rule of 5 used here - Class contains resources.
+// Rule of 5 used here, but the simulation can only be moved - Class contains resources, copies are taken as snapshots.
 
 // Constructor: Initialize the simulation using a configuration file
-Simulation::Simulation(const string &configFilePath) : isRunning(false), planCounter(0),actionsLog(), plans(), settlements(),
-    facilitiesOptions() {
+Simulation::Simulation(const string &configFilePath) : isRunning(false), planCounter(0), numOfThreads(1), fastForward(false), compact(false), stepCore(StepCore::PLANS), backupMode(BackupMode::SNAPSHOTS), checkpointInterval(0), workers(nullptr), scoreIndex(new ScoreIndex()), categoryIndex(new CategoryIndex()), planSolver(new PlanSolver()), undoJournal(new UndoJournal()), writeAheadLog(nullptr), actionsLog(), plans(), settlements(),
+    facilitiesOptions(), sharedFacilitiesOptions(), settlementsByName(), facilitiesByName(), planIndexById(), plansByPolicy(), snapshots(), replayBase() {
 
     // Open the configuration file for reading
     ifstream configFile(configFilePath);
@@ -47,9 +47,10 @@ Simulation::Simulation(const string &configFilePath) : isRunning(false), planCou
 
             // Determine the selection policy
             if (args[2] == "nve") policy = new NaiveSelection();
-            else if (args[2] == "bal") policy = new BalancedSelection(0,0,0);
-            else if (args[2] == "eco") policy = new EconomySelection();
-            else if (args[2] == "env") policy = new SustainabilitySelection();
+            else if (args[2] == "bal") policy = new BalancedSelection(0,0,0, scoreIndex);
+            else if (args[2] == "eco") policy = new EconomySelection(categoryIndex);
+            else if (args[2] == "env") policy = new SustainabilitySelection(categoryIndex);
+            else if (args[2] == "opt") policy = new OptimalSelection(Plan::getCapacity(settlement.getType()), planSolver);
             else throw runtime_error("Unknown selection policy");
 
             addPlan(settlement, policy);
@@ -59,101 +60,42 @@ Simulation::Simulation(const string &configFilePath) : isRunning(false), planCou
     configFile.close();
 }
 
-// Copy Constructor
-Simulation::Simulation(const Simulation &other)
-    : isRunning(other.isRunning),
-      planCounter(other.planCounter),
-      actionsLog(),
-      plans(),
-      settlements(),
-      facilitiesOptions(other.facilitiesOptions) {
-
-    // Copy settlements
-    for (const auto *settlement : other.settlements) {
-        settlements.push_back(new Settlement(*settlement)); 
-    }
-
-    // Copy plans and match them with the new settlements
-    for (const auto &plan : other.plans) {
-        const Settlement &oldSettlement = plan.getSettlement();
-        Settlement *newSettlement = nullptr;
-        
-        // Find the corresponding settlement in the new list
-        for (auto *settlement : settlements) {
-            if (settlement->getName() == oldSettlement.getName()) {
-                newSettlement = settlement; // Found the corresponding settlement
-                break;
-            }
-        }
-
-        // Create a copy of the plan
-        plans.emplace_back(plan.getPlanId(), 
-                           *newSettlement, 
-                           plan.getSelectionPolicy()->clone(), 
-                           facilitiesOptions);
-    }
-
-    // Copy the action log
-    for (const auto *action : other.actionsLog) {
-        actionsLog.push_back(action->clone()); 
-    }
-}
-
-// Assignment Operator
-Simulation &Simulation::operator=(const Simulation &other) {
-    if (this == &other) return *this; // Handle self-assignment
-
-    // Clean up current state
-    for (auto *settlement : settlements) {
-        delete settlement;
-        settlement = nullptr;
-    }
-    settlements.clear();
-
-    for (auto *action : actionsLog) {
-        delete action;
-    }
-    actionsLog.clear();
-
-    plans.clear();
-    facilitiesOptions.clear();
-
-    // Copy other fields
-    isRunning = other.isRunning;
-    planCounter = other.planCounter;
-
-    // Deep copy of settlements
-    for (Settlement* settlement : other.settlements) {
-        settlements.push_back(new Settlement(settlement->getName(), settlement->getType()));
-    }
-
-    // Deep copy of facilitiesOptions
-    facilitiesOptions = vector<FacilityType>(other.facilitiesOptions);
-    
-     // Deep copy plans
-    for (const auto& plan : other.plans) {
-        plans.emplace_back(plan); // Calls Plan's copy constructor
-    }
-
-    // Deep copy of actionsLog
-    for (const auto *action : other.actionsLog) {
-        actionsLog.push_back(action->clone()); 
-    }
-
-    return *this;
-}
-
 // Move Constructor
 Simulation::Simulation(Simulation &&other) noexcept
     : isRunning(other.isRunning),
       planCounter(other.planCounter),
+      numOfThreads(other.numOfThreads),
+      fastForward(other.fastForward),
+      compact(other.compact),
+      stepCore(other.stepCore),
+      backupMode(other.backupMode),
+      checkpointInterval(other.checkpointInterval),
+      workers(other.workers),
+      scoreIndex(other.scoreIndex),
+      categoryIndex(other.categoryIndex),
+      planSolver(other.planSolver),
+      undoJournal(other.undoJournal),
+      writeAheadLog(other.writeAheadLog),
       actionsLog(move(other.actionsLog)),
       plans(move(other.plans)),
       settlements(move(other.settlements)),
-      facilitiesOptions(move(other.facilitiesOptions)) {
+      facilitiesOptions(move(other.facilitiesOptions)),
+      sharedFacilitiesOptions(move(other.sharedFacilitiesOptions)),
+      settlementsByName(move(other.settlementsByName)),
+      facilitiesByName(move(other.facilitiesByName)),
+      planIndexById(move(other.planIndexById)),
+      plansByPolicy(move(other.plansByPolicy)),
+      snapshots(move(other.snapshots)),
+      replayBase(move(other.replayBase)) {
     // Clear the state of the moved-from object
     other.isRunning = false;
     other.planCounter = 0;
+    other.workers = nullptr;
+    other.scoreIndex = nullptr;
+    other.categoryIndex = nullptr;
+    other.planSolver = nullptr;
+    other.undoJournal = nullptr;
+    other.writeAheadLog = nullptr;
 }
 
 // Move Assignment Operator
@@ -161,48 +103,68 @@ Simulation &Simulation::operator=(Simulation &&other) noexcept {
     if (this == &other) return *this; // Handle self-assignment
 
     // Clean up current state
-    for (auto *settlement : this->settlements) {
-        delete settlement;
+    delete workers;
+    delete scoreIndex;
+    delete categoryIndex;
+    delete planSolver;
+    delete undoJournal;
+    delete writeAheadLog;
+    for (const auto &named : snapshots) {
+        delete named.second;
     }
-    this->settlements.clear();
-
-    for (auto *action : actionsLog) {
-        delete action;
-    }
-    actionsLog.clear();
-
-    plans.clear();
-    facilitiesOptions.clear();
 
     // Steal resources from the moved-from object
     isRunning = other.isRunning;
     planCounter = other.planCounter;
+    numOfThreads = other.numOfThreads;
+    fastForward = other.fastForward;
+    compact = other.compact;
+    stepCore = other.stepCore;
+    backupMode = other.backupMode;
+    checkpointInterval = other.checkpointInterval;
+    workers = other.workers;
+    scoreIndex = other.scoreIndex;
+    categoryIndex = other.categoryIndex;
+    planSolver = other.planSolver;
+    undoJournal = other.undoJournal;
+    writeAheadLog = other.writeAheadLog;
     actionsLog = move(other.actionsLog);
     plans = move(other.plans);
     settlements = move(other.settlements);
     facilitiesOptions = move(other.facilitiesOptions);
+    sharedFacilitiesOptions = move(other.sharedFacilitiesOptions);
+    settlementsByName = move(other.settlementsByName);
+    facilitiesByName = move(other.facilitiesByName);
+    planIndexById = move(other.planIndexById);
+    plansByPolicy = move(other.plansByPolicy);
+    snapshots = move(other.snapshots);
+    replayBase = move(other.replayBase);
+    other.snapshots.clear();
 
     // Reset the moved-from object
     other.isRunning = false;
     other.planCounter = 0;
+    other.workers = nullptr;
+    other.scoreIndex = nullptr;
+    other.categoryIndex = nullptr;
+    other.planSolver = nullptr;
+    other.undoJournal = nullptr;
+    other.writeAheadLog = nullptr;
 
     return *this;
 }
 
 // Destructor 
  Simulation::~Simulation() {
-    for (auto* settlement : settlements) {
-        delete settlement;
+    delete workers;
+    delete scoreIndex;
+    delete categoryIndex;
+    delete planSolver;
+    delete undoJournal;
+    delete writeAheadLog;
+    for (const auto &named : snapshots) {
+        delete named.second;
     }
-    settlements.clear();
-
-
-    for (auto* action : actionsLog) {
-        delete action;
-    }
-    actionsLog.clear();
-
-
 }
 
 
@@ -247,120 +209,436 @@ void Simulation::start() {
                 if (args.size() != 3) throw runtime_error("Invalid changePolicy command");
                 action = new ChangePlanPolicy(stoi(args[1]), args[2]);
             } 
+            else if (args[0] == "compare") {
+                if (args.size() != 3) throw runtime_error("Invalid compare command");
+                action = new ComparePolicies(stoi(args[1]), stoi(args[2]));
+            } 
             else if (args[0] == "log") {
-                action = new PrintActionsLog();
+                // log [from] [count] [--type=<command>]... [--errors]
+                vector<size_t> range;
+                vector<ActionType> types;
+                bool errorsOnly = false;
+                for (size_t i = 1; i < args.size(); i++) {
+                    if (args[i] == "--errors") {
+                        errorsOnly = true;
+                    } else if (args[i].compare(0, 7, "--type=") == 0) {
+                        types.push_back(PrintActionsLog::parseType(args[i].substr(7)));
+                    } else if (range.size() < 2 && args[i].find_first_not_of("0123456789") == string::npos) {
+                        range.push_back(stoul(args[i]));
+                    } else {
+                        throw runtime_error("Invalid log command");
+                    }
+                }
+                action = new PrintActionsLog(range.size() > 0 ? range[0] : 0, range.size() > 1 ? range[1] : PrintActionsLog::allActions,
+                                             types, errorsOnly);
+            } 
+            else if (args[0] == "stats") {
+                action = new PrintStats();
             } 
             else if (args[0] == "close") {
                 action = new Close();
             } 
             else if (args[0] == "backup") {
-                action = new BackupSimulation();
+                if (args.size() > 2) throw runtime_error("Invalid backup command");
+                action = (args.size() == 2) ? new BackupSimulation(args[1]) : new BackupSimulation();
             } 
             else if (args[0] == "restore") {
-                action = new RestoreSimulation();
+                if (args.size() > 2) throw runtime_error("Invalid restore command");
+                action = (args.size() == 2) ? new RestoreSimulation(args[1]) : new RestoreSimulation();
+            } 
+            else if (args[0] == "save") {
+                if (args.size() != 2) throw runtime_error("Invalid save command");
+                action = new SaveSimulation(args[1]);
+            } 
+            else if (args[0] == "load") {
+                if (args.size() != 2) throw runtime_error("Invalid load command");
+                action = new LoadSimulation(args[1]);
+            } 
+            else if (args[0] == "undo") {
+                if (args.size() > 2) throw runtime_error("Invalid undo command");
+                action = new Undo((args.size() == 2) ? stoi(args[1]) : 1);
+            } 
+            else if (args[0] == "snapshots") {
+                action = new PrintSnapshots();
+            } 
+            else if (args[0] == "dropSnapshot") {
+                if (args.size() != 2) throw runtime_error("Invalid dropSnapshot command");
+                action = new DropSnapshot(args[1]);
             } 
             else {
                 throw runtime_error("Unknown command");
             }
-
-            // If action was created, execute it and add it to the log
-            if (action) {
-                action->act(*this);
-                addAction(action);
-            }
         } 
         catch (const exception &e) {
             // Print error message
-            if (action) delete action; // Clean up memory if an action was created but not added
             cout << "Error: " << e.what() << endl;
+            continue;
+        }
+
+        // Execute the action and add it to the log
+        execute(action);
+    }
+}
+
+// Acts on an action and adds it to the log, taking ownership of it. With a write-ahead log, the action is written
+// to it before acting (after, for one that only prints or saves), and with the undo journal on, the state before
+// a state-changing action is journaled.
+void Simulation::execute(BaseAction *action) {
+    try {
+        if (writeAheadLog && action->writesAhead()) {
+            writeAheadLog->append(*action);
+        }
+        if (undoJournal->isEnabled() && action->changesState()) {
+            // Journal the state before the command, so it can be undone. A command that threw may have changed
+            // the state midway, so it is journaled too, and undoing it doesn't take back the command before it.
+            SimulationSnapshot before(*this);
+            try {
+                action->act(*this);
+            } catch (const exception &) {
+                undoJournal->record(before);
+                throw;
+            }
+            if (action->getStatus() == ActionStatus::COMPLETED) {
+                undoJournal->record(before);
+            }
+        } else {
+            action->act(*this);
+        }
+        if (writeAheadLog && !action->writesAhead()) {
+            writeAheadLog->append(*action);
+        }
+        addAction(action);
+    }
+    catch (const exception &e) {
+        // Print error message
+        delete action; // Clean up memory, the action wasn't added
+        cout << "Error: " << e.what() << endl;
+
+        // An action that failed midway may have changed the state without being logged, so in replay mode
+        // that state becomes the checkpoint: replaying the log from an earlier one would miss the change
+        if (replayBase) {
+            replayBase = make_shared<const SimulationSnapshot>(*this);
         }
     }
 }
 
 // Add a plan to the simulation
 void Simulation::addPlan(const Settlement &settlement, SelectionPolicy *selectionPolicy) {
-    plans.emplace_back(planCounter++, settlement, selectionPolicy, facilitiesOptions);
+    planIndexById.push_back(plans.size());
+    plans.add(planCounter++, settlement, selectionPolicy, facilitiesOptions);
+    plans.back().setCompact(compact);
+    if (!plansByPolicy.empty()) {
+        plansByPolicy[static_cast<size_t>(plans.back().getPolicyType())].push_back(plans.size() - 1);
+    }
 }
 
-// Add a new action to the log
+// Add a new action to the log, which takes ownership of it and keeps only its record
 void Simulation::addAction(BaseAction *action) {
-    actionsLog.push_back(action);
+    actionsLog.append(*action);
+
+    // In replay mode, a checkpoint every checkpointInterval actions bounds what a restore replays
+    if (replayBase && checkpointInterval > 0 && actionsLog.size() - replayBase->actionsLog.size() >= checkpointInterval) {
+        replayBase = make_shared<const SimulationSnapshot>(*this);
+    }
+    delete action; // The log keeps its record
 }
 
-// Add a settlement to the simulation
+// Add a settlement to the simulation, which takes ownership of it
 bool Simulation::addSettlement(Settlement *settlement) {
-    settlements.push_back(settlement);
+    settlements.push_back(shared_ptr<Settlement>(settlement));
+    settlementsByName[settlement->getName()] = settlement;
     return true;
 }
 
 // Add a facility type to the simulations
 bool Simulation::addFacility(FacilityType facility) {
+    facilitiesByName[facility.getName()] = facilitiesOptions.size();
     facilitiesOptions.push_back(facility);
+    categoryIndex->add(facilitiesOptions.back());
+    sharedFacilitiesOptions.reset(); // The snapshots taken so far keep the old copy
     return true;
 }
 
 // Check if a settlement exists in the simulation
 bool Simulation::isSettlementExists(const string &settlementName) {
-    for (size_t i = 0; i < settlements.size(); i++) {
-        if (settlements[i]->getName() == settlementName) {
-            return true; 
-        }
-    }
-    return false; 
+    return settlementsByName.count(settlementName) != 0;
 }
 
 // Check if a type of facility exists in the simulation
 bool Simulation::isFacilityExists(const string &facilityName) {
-    for (size_t i = 0; i < facilitiesOptions.size(); ++i) {
-        if (facilitiesOptions[i].getName() == facilityName) {
-            return true; 
-        }
-    }
-    return false; 
+    return facilitiesByName.count(facilityName) != 0;
 }
 
 // Check if a plan exists in the simulation
-bool Simulation::isPlanExists(const int planId) {
-    for (size_t i = 0; i < plans.size(); ++i) {
-        if (plans[i].getPlanId() == planId) {
-            return true; 
-        }
-    }
-    return false; 
+bool Simulation::isPlanExists(const int planId) const {
+    return planId >= 0 && static_cast<size_t>(planId) < planIndexById.size();
 }
 
 // Get a settlement by name
 Settlement &Simulation::getSettlement(const string &settlementName) {
-    for (auto *s : settlements) {
-        if (s->getName() == settlementName) {
-            return *s;
-        }
+    auto found = settlementsByName.find(settlementName);
+    if (found == settlementsByName.end()) {
+        throw runtime_error("Settlement not found");
     }
-    throw runtime_error("Settlement not found");
+    return *found->second;
 }
 
-// Get a plan by ID
+// Get a plan by ID, for changing it. The plan's chunk is copied first if a snapshot shares it, so the reference
+// is only good until the next snapshot is taken (or the plans are restored or loaded): get the plan again after that.
 Plan &Simulation::getPlan(const int planID) {
-    for (auto &plan : plans) {
-        if (plan.getPlanId() == planID) {
-            return plan;
+    if (!isPlanExists(planID)) {
+        throw runtime_error("Plan not found");
+    }
+    plansByPolicy.clear(); // The plan may be given another policy
+    return plans[planIndexById[planID]];
+}
+
+// Get a plan by ID, for reading it: the snapshots sharing it keep sharing it
+const Plan &Simulation::getPlan(const int planID) const {
+    if (!isPlanExists(planID)) {
+        throw runtime_error("Plan not found");
+    }
+    const PlanStorage &readPlans = plans;
+    return readPlans[planIndexById[planID]];
+}
+
+// The indexes the plans of this simulation select through
+const ScoreIndex *Simulation::getScoreIndex() const {
+    return scoreIndex;
+}
+
+const CategoryIndex *Simulation::getCategoryIndex() const {
+    return categoryIndex;
+}
+
+const UndoJournal *Simulation::getUndoJournal() const {
+    return undoJournal;
+}
+
+const PlanSolver *Simulation::getPlanSolver() const {
+    return planSolver;
+}
+
+// A new policy named policyName for the plan, starting from where the plan stands now (as changePolicy does).
+// Returns nullptr for an unknown name, or for a category policy without a facility of its category.
+SelectionPolicy *Simulation::createSelectionPolicy(const Plan &plan, const string &policyName) const {
+    if (policyName == "nve") {
+        return new NaiveSelection();
+    }
+    if (policyName == "bal") {
+        // Balance from the current scores plus what is already under construction
+        int lifeQualityScore = plan.getlifeQualityScore();
+        int economyScore = plan.getEconomyScore();
+        int environmentScore = plan.getEnvironmentScore();
+        for (const Facility *facility : plan.getFacilitiesUnderConstruction()) {
+            lifeQualityScore += facility->getLifeQualityScore();
+            economyScore += facility->getEconomyScore();
+            environmentScore += facility->getEnvironmentScore();
+        }
+        return new BalancedSelection(lifeQualityScore, economyScore, environmentScore, scoreIndex);
+    }
+    if (policyName == "eco" && categoryIndex->hasCategory(FacilityCategory::ECONOMY)) {
+        return new EconomySelection(categoryIndex);
+    }
+    if (policyName == "sus" && categoryIndex->hasCategory(FacilityCategory::ENVIRONMENT)) {
+        return new SustainabilitySelection(categoryIndex);
+    }
+    if (policyName == "opt") {
+        // Plan from the current scores and what is under construction
+        PlanSolver::State state;
+        state.lifeQualityScore = plan.getlifeQualityScore();
+        state.economyScore = plan.getEconomyScore();
+        state.environmentScore = plan.getEnvironmentScore();
+        for (const Facility *facility : plan.getFacilitiesUnderConstruction()) {
+            state.building.push_back({facility->getTypeIndex(), facility->getTimeLeft()});
         }
+        return new OptimalSelection(plan.getCapacity(), planSolver, state);
     }
-    throw runtime_error("Plan not found");
+    return nullptr;
+}
+
+const WriteAheadLog *Simulation::getWriteAheadLog() const {
+    return writeAheadLog;
 }
 
 // Get the action log (read-only).
-const std::vector<BaseAction*>& Simulation::getActionsLog() const {
+const ActionLog &Simulation::getActionsLog() const {
     return actionsLog;
 }
 
+// Set how many threads step plans (1 keeps everything on the calling thread)
+void Simulation::setNumOfThreads(const int numOfThreads) {
+    if (numOfThreads < 1) {
+        throw invalid_argument("Number of threads must be positive");
+    }
+    if (workers != nullptr && workers->size() != numOfThreads) {
+        delete workers;
+        workers = nullptr;
+    }
+    this->numOfThreads = numOfThreads;
+    planSolver->setNumOfThreads(numOfThreads);
+}
+
+int Simulation::getNumOfThreads() const {
+    return numOfThreads;
+}
+
+// Let round-robin plans detect their cycle and skip whole cycles when stepping
+void Simulation::setFastForward(const bool fastForward) {
+    this->fastForward = fastForward;
+}
+
+// Keep only per-type counts of operational facilities, in every plan from now on
+void Simulation::setCompact(const bool compact) {
+    this->compact = compact;
+    for (auto &plan : plans) {
+        plan.setCompact(compact);
+    }
+}
+
+// Choose which core steps the plans, both give the same results
+void Simulation::setStepCore(const StepCore stepCore) {
+    this->stepCore = stepCore;
+}
+
+// How many steps each opt plan looks ahead
+void Simulation::setSolverHorizon(const int horizon) {
+    planSolver->setHorizon(horizon);
+}
+
+// What the opt plans maximize
+void Simulation::setSolverObjective(const PlanSolver::Objective objective, const int lifeQualityWeight, const int economyWeight, const int environmentWeight) {
+    planSolver->setObjective(objective, lifeQualityWeight, economyWeight, environmentWeight);
+}
+
+// Sets the bytes the undo journal may hold, 0 to turn it off
+void Simulation::setUndoMemoryLimit(const size_t memoryLimit) {
+    undoJournal->setMemoryLimit(memoryLimit);
+}
+
+// Chooses how backups and named snapshots are taken. In replay mode the current state is the first checkpoint,
+// and another one is taken every checkpointInterval actions (0 for none): each holds what changed since it was taken.
+void Simulation::setBackupMode(const BackupMode backupMode, const size_t checkpointInterval) {
+    this->backupMode = backupMode;
+    this->checkpointInterval = checkpointInterval;
+    replayBase = (backupMode == BackupMode::REPLAY) ? make_shared<const SimulationSnapshot>(*this) : nullptr;
+}
+
+// Acts again on the commands recorded in the write-ahead log at path, without printing anything, to get back to the
+// state and the log after the last of them, then writes the commands to come to it (see WriteAheadLog).
+// The commands that only printed or saved are logged as they went, without acting on them again.
+// The simulation has to be as it was when the log was started: from the same configuration, with the same options.
+// Returns the number of commands recovered.
+size_t Simulation::openWriteAheadLog(const string &path, const size_t syncCount, const int syncInterval) {
+    WriteAheadLog *opened = new WriteAheadLog(path, syncCount, syncInterval);
+    streambuf *output = cout.rdbuf(nullptr);
+    size_t numOfCommands = 0;
+    try {
+        numOfCommands = opened->recover([this](BaseAction *action) { execute(action); },
+                                        [this](BaseAction *action) { addAction(action); });
+    } catch (...) {
+        cout.rdbuf(output);
+        delete opened;
+        throw;
+    }
+    cout.rdbuf(output);
+    delete writeAheadLog;
+    writeAheadLog = opened;
+    return numOfCommands;
+}
+
 // Perform one simulation step by advancing all plans.
 void Simulation::step() {
+    scoreIndex->update(facilitiesOptions);
     for (auto &plan : plans) {
         plan.step();
     }
 }
 
+// Perform numOfSteps simulation steps.
+// Plans don't share any mutable state, so each plan is taken through all the steps at once and the plans
+// are split across the workers. With the PLANS core the plans of each policy type are stepped together, through
+// the stepping loop compiled for that type, and each plan skips the steps on which nothing completes; with the ARRAYS core a PlanStateEngine sweeps the plans' state tick by tick.
+// If some plan may fail mid-way, step tick by tick instead so the error leaves the exact same state behind.
+void Simulation::step(const int numOfSteps) {
+    for (const auto &plan : plans) {
+        if (!plan.canStep()) {
+            for (int i = 0; i < numOfSteps; i++) {
+                step();
+            }
+            return;
+        }
+    }
+    scoreIndex->update(facilitiesOptions);
+
+    if (stepCore == StepCore::ARRAYS) {
+        PlanStateEngine engine(facilitiesOptions);
+        for (auto &plan : plans) {
+            engine.load(plan);
+        }
+        runSlices(plans.size(), [&engine, numOfSteps](size_t begin, size_t end) {
+            engine.step(numOfSteps, begin, end);
+        });
+        engine.store();
+        return;
+    }
+
+    plans.unshare(); // The workers then only read the storage's chunk table
+    groupPlans();
+    stepGroup<NaiveSelection>(plansByPolicy[static_cast<size_t>(PolicyType::NAIVE)], numOfSteps);
+    stepGroup<BalancedSelection>(plansByPolicy[static_cast<size_t>(PolicyType::BALANCED)], numOfSteps);
+    stepGroup<EconomySelection>(plansByPolicy[static_cast<size_t>(PolicyType::ECONOMY)], numOfSteps);
+    stepGroup<SustainabilitySelection>(plansByPolicy[static_cast<size_t>(PolicyType::SUSTAINABILITY)], numOfSteps);
+    stepGroup<OptimalSelection>(plansByPolicy[static_cast<size_t>(PolicyType::OPTIMAL)], numOfSteps);
+    stepGroup<SelectionPolicy>(plansByPolicy[static_cast<size_t>(PolicyType::OTHER)], numOfSteps);
+}
+
+// Groups the plans by the type of their policy, unless they still are since a plan last could have changed policy
+void Simulation::groupPlans() {
+    if (!plansByPolicy.empty()) return;
+    plansByPolicy.resize(static_cast<size_t>(PolicyType::OTHER) + 1);
+    const PlanStorage &groupedPlans = plans;
+    for (size_t i = 0; i < groupedPlans.size(); i++) {
+        plansByPolicy[static_cast<size_t>(groupedPlans[i].getPolicyType())].push_back(i);
+    }
+}
+
+// Steps the plans at the given positions, whose policies are all Policy objects, numOfSteps steps
+template <class Policy>
+void Simulation::stepGroup(const vector<size_t> &group, const int numOfSteps) {
+    runSlices(group.size(), [this, &group, numOfSteps](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            plans[group[i]].stepAs<Policy>(numOfSteps, fastForward);
+        }
+    });
+}
+
+// Steps plans forked from this simulation's plans numOfSteps times, each fork on a thread of its own.
+// The forks only share read-only state (catalog, settlements, indexes), so the simulation itself is left as it was.
+void Simulation::stepForks(PlanStorage &forks, const int numOfSteps) {
+    scoreIndex->update(facilitiesOptions);
+    ThreadPool forkWorkers(static_cast<int>(forks.size()));
+    forkWorkers.run(forks.size(), [this, &forks, numOfSteps](size_t i) {
+        forks[i].step(numOfSteps, fastForward);
+    });
+}
+
+// Splits [0, count) into slices and runs them on the workers (or right here with a single thread)
+void Simulation::runSlices(const size_t count, const function<void(size_t, size_t)> &slice) {
+    if (numOfThreads == 1 || count < 2) {
+        slice(0, count);
+        return;
+    }
+    if (workers == nullptr) {
+        workers = new ThreadPool(numOfThreads);
+    }
+    // A few slices per thread even out plans that cost more than others (e.g. "bal")
+    size_t numOfSlices = min(count, static_cast<size_t>(numOfThreads) * 4);
+    workers->run(numOfSlices, [count, numOfSlices, &slice](size_t i) {
+        slice(count * i / numOfSlices, count * (i + 1) / numOfSlices);
+    });
+}
+
 // Print results of all plans and stop the simulation
 void Simulation::close() {
     for (const auto& plan : plans) {
@@ -378,6 +656,271 @@ void Simulation::close() {
     cout << "Simulation closed successfully." << endl;
 }
 
+// Puts the simulation back in the state of a snapshot taken of it. The snapshot's parts are shared, not copied,
+// and the lookup indexes are only updated for what differs, so this costs as much as what changed since the snapshot.
+// The plans' policies already point at this simulation's indexes and solver.
+// A replay snapshot is rebuilt instead, at the cost of the actions it replays.
+void Simulation::restore(const SimulationSnapshot &snapshot) {
+    if (snapshot.isReplayed()) {
+        replay(snapshot);
+        return;
+    }
+    planCounter = snapshot.planCounter;
+
+    // The catalog only changed if a type was added since the snapshot (or since any of the snapshots in between)
+    if (snapshot.facilitiesOptions != sharedFacilitiesOptions) {
+        restoreFacilitiesOptions(snapshot.facilitiesOptions);
+    }
+
+    size_t numOfKeptSettlements = settlements.countShared(snapshot.settlements);
+    for (size_t i = numOfKeptSettlements; i < settlements.size(); i++) {
+        settlementsByName.erase(settlements[i]->getName());
+    }
+    settlements = snapshot.settlements;
+    for (size_t i = numOfKeptSettlements; i < settlements.size(); i++) {
+        settlementsByName[settlements[i]->getName()] = settlements[i].get();
+    }
+
+    plans = snapshot.plans;
+    plansByPolicy.clear();
+    const PlanStorage &restoredPlans = plans;
+    size_t numOfKeptPlans = min(planIndexById.size(), restoredPlans.size());
+    planIndexById.resize(planCounter);
+    for (size_t i = numOfKeptPlans; i < restoredPlans.size(); i++) {
+        planIndexById[restoredPlans[i].getPlanId()] = i;
+    }
+
+    actionsLog = snapshot.actionsLog;
+
+    // In replay mode, the state restored is where the snapshots taken from now on are replayed from
+    if (backupMode == BackupMode::REPLAY) {
+        replayBase = make_shared<const SimulationSnapshot>(snapshot);
+    }
+}
+
+// Rebuilds the state of a replay snapshot: its base, with the completed actions logged since applied again.
+// A restore, undo or load in the log has nothing to apply: the log before it is already the log of the state it went to.
+void Simulation::replay(const SimulationSnapshot &snapshot) {
+    restore(*snapshot.replayBase);
+    snapshot.actionsLog.visit(snapshot.replayBase->actionsLog.size(), snapshot.actionsLog.size(), [this](const BaseAction &action) {
+        if (action.getStatus() == ActionStatus::COMPLETED) {
+            action.replay(*this);
+        }
+    });
+    actionsLog = snapshot.actionsLog;
+    replayBase = snapshot.replayBase;
+}
+
+// Puts the simulation back in the state before its last numOfCommands state-changing commands (see UndoJournal).
+// Like restore(), this costs as much as what those commands changed.
+void Simulation::undo(const int numOfCommands) {
+    if (numOfCommands < 1) {
+        throw runtime_error("Invalid number of commands");
+    }
+    if (static_cast<size_t>(numOfCommands) > undoJournal->size()) {
+        throw runtime_error("Not enough history to undo");
+    }
+    restore(undoJournal->get(numOfCommands));
+    undoJournal->drop(numOfCommands);
+}
+
+// A snapshot of the current state, a full one or a replay one depending on the backup mode
+SimulationSnapshot *Simulation::takeSnapshot() {
+    if (backupMode == BackupMode::REPLAY) {
+        return new SimulationSnapshot(*this, replayBase);
+    }
+    return new SimulationSnapshot(*this);
+}
+
+// Takes a snapshot under a name, replacing the one that had it
+void Simulation::addSnapshot(const string &snapshotName) {
+    SimulationSnapshot *snapshot = takeSnapshot();
+    auto named = snapshots.find(snapshotName);
+    if (named != snapshots.end()) {
+        delete named->second;
+        named->second = snapshot;
+    } else {
+        snapshots[snapshotName] = snapshot;
+    }
+}
+
+bool Simulation::isSnapshotExists(const string &snapshotName) const {
+    return snapshots.find(snapshotName) != snapshots.end();
+}
+
+const SimulationSnapshot &Simulation::getSnapshot(const string &snapshotName) const {
+    auto named = snapshots.find(snapshotName);
+    if (named == snapshots.end()) {
+        throw runtime_error("Snapshot doesn't exist");
+    }
+    return *named->second;
+}
+
+// Deletes a named snapshot, freeing what only it held
+void Simulation::dropSnapshot(const string &snapshotName) {
+    auto named = snapshots.find(snapshotName);
+    if (named != snapshots.end()) {
+        delete named->second;
+        snapshots.erase(named);
+    }
+}
+
+const map<string, SimulationSnapshot*> &Simulation::getSnapshots() const {
+    return snapshots;
+}
+
+// Rewrites the catalog in place to another one, keeping the types they have in common where they are
+void Simulation::restoreFacilitiesOptions(const shared_ptr<const vector<FacilityType>> &restored) {
+    size_t numOfKept = 0;
+    while (numOfKept < facilitiesOptions.size() && numOfKept < restored->size() && facilitiesOptions[numOfKept] == (*restored)[numOfKept]) {
+        numOfKept++;
+    }
+    while (facilitiesOptions.size() > numOfKept) {
+        facilitiesByName.erase(facilitiesOptions.back().getName());
+        facilitiesOptions.pop_back();
+    }
+    for (size_t i = numOfKept; i < restored->size(); i++) {
+        facilitiesByName[(*restored)[i].getName()] = i;
+        facilitiesOptions.push_back((*restored)[i]);
+    }
+    categoryIndex->rebuild(facilitiesOptions);
+    scoreIndex->clear(); // The catalog may have changed in place
+    sharedFacilitiesOptions = restored;
+}
+
+// Writes the simulation's state to a binary image at path (see SimulationImage): the catalog, the settlements,
+// the plans with their policies' state and their facilities, and the actions log.
+// The settings given on the command line, the backup and the named snapshots are not part of it.
+void Simulation::save(const string &path) const {
+    ImageWriter writer;
+    writer.writeInt(planCounter);
+
+    writer.writeSize(facilitiesOptions.size());
+    for (const FacilityType &type : facilitiesOptions) {
+        writer.writeString(type.getName());
+        writer.writeSize(static_cast<size_t>(type.getCategory()));
+        writer.writeInt(type.getCost());
+        writer.writeInt(type.getLifeQualityScore());
+        writer.writeInt(type.getEconomyScore());
+        writer.writeInt(type.getEnvironmentScore());
+    }
+
+    unordered_map<const Settlement*, size_t> settlementIndexes;
+    writer.writeSize(settlements.size());
+    for (const shared_ptr<Settlement> &settlement : settlements) {
+        size_t settlementIndex = settlementIndexes.size();
+        settlementIndexes[settlement.get()] = settlementIndex;
+        writer.writeString(settlement->getName());
+        writer.writeSize(static_cast<size_t>(settlement->getType()));
+    }
+
+    const PlanStorage &savedPlans = plans;
+    writer.writeSize(savedPlans.size());
+    for (const Plan &plan : savedPlans) {
+        writer.writeInt(plan.getPlanId());
+        writer.writeSize(settlementIndexes.at(&plan.getSettlement()));
+        writer.writeString(plan.getSelectionPolicy()->toString());
+        plan.getSelectionPolicy()->save(writer);
+        plan.save(writer);
+    }
+
+    writer.writeSize(actionsLog.size());
+    actionsLog.visit(0, actionsLog.size(), [&writer](const BaseAction &action) {
+        action.save(writer);
+    });
+    writer.writeToFile(path);
+}
+
+// Replaces the simulation's state with an image written by save(). The image is mapped rather than read,
+// and restored like a snapshot, so the lookup indexes are updated as for restore(). An image that can't be
+// read leaves the simulation as it was.
+void Simulation::load(const string &path) {
+    ImageReader reader(path); // Checks the whole image before anything is changed
+    load(reader);
+}
+
+// The same, from the bytes of an image file already read (see LoadSimulation)
+void Simulation::load(const vector<unsigned char> &image) {
+    ImageReader reader(image);
+    load(reader);
+}
+
+// Restores the state in the body of an image, checked by the reader
+void Simulation::load(ImageReader &reader) {
+    SimulationSnapshot previous(*this);
+    try {
+        SimulationSnapshot loaded(*this);
+        loaded.planCounter = reader.readInt();
+
+        // The plans' facilities look their types up in the live catalog, so it is replaced first
+        vector<FacilityType> loadedFacilitiesOptions;
+        for (size_t i = reader.readSize(); i > 0; i--) {
+            string name = reader.readString();
+            FacilityCategory category = static_cast<FacilityCategory>(reader.readSize(static_cast<size_t>(FacilityCategory::ENVIRONMENT) + 1));
+            int price = reader.readInt();
+            int lifeQualityScore = reader.readInt();
+            int economyScore = reader.readInt();
+            int environmentScore = reader.readInt();
+            loadedFacilitiesOptions.emplace_back(name, category, price, lifeQualityScore, economyScore, environmentScore);
+        }
+        loaded.facilitiesOptions = make_shared<const vector<FacilityType>>(move(loadedFacilitiesOptions));
+        restoreFacilitiesOptions(loaded.facilitiesOptions);
+
+        loaded.settlements.clear();
+        for (size_t i = reader.readSize(); i > 0; i--) {
+            string name = reader.readString();
+            SettlementType type = static_cast<SettlementType>(reader.readSize(static_cast<size_t>(SettlementType::METROPOLIS) + 1));
+            loaded.settlements.push_back(make_shared<Settlement>(name, type));
+        }
+
+        loaded.plans.clear();
+        for (size_t i = reader.readSize(); i > 0; i--) {
+            int planId = reader.readInt();
+            if (planId != static_cast<int>(loaded.plans.size())) {
+                throw runtime_error("Invalid image");
+            }
+            const Settlement &settlement = *loaded.settlements[reader.readSize(loaded.settlements.size())];
+            string policyName = reader.readString();
+            SelectionPolicy *policy = nullptr;
+            if (policyName == "nve") policy = new NaiveSelection();
+            else if (policyName == "bal") policy = new BalancedSelection(0, 0, 0, scoreIndex);
+            else if (policyName == "eco") policy = new EconomySelection(categoryIndex);
+            else if (policyName == "sus") policy = new SustainabilitySelection(categoryIndex);
+            else if (policyName == "opt") policy = new OptimalSelection(Plan::getCapacity(settlement.getType()), planSolver);
+            else throw runtime_error("Invalid image");
+            Plan &plan = loaded.plans.add(planId, settlement, policy, facilitiesOptions);
+            policy->load(reader, facilitiesOptions);
+            plan.load(reader);
+            plan.setCompact(compact);
+        }
+        if (loaded.planCounter != static_cast<int>(loaded.plans.size())) {
+            throw runtime_error("Invalid image");
+        }
+
+        loaded.actionsLog.clear();
+        for (size_t i = reader.readSize(); i > 0; i--) {
+            BaseAction *action = BaseAction::load(reader);
+            loaded.actionsLog.append(*action);
+            delete action;
+        }
+        if (!reader.atEnd()) {
+            throw runtime_error("Invalid image");
+        }
+        restore(loaded);
+    } catch (const exception &) {
+        restore(previous);
+        throw;
+    }
+}
+
+// The catalog as the snapshots keep it: one copy, shared by every snapshot taken until the next type is added
+shared_ptr<const vector<FacilityType>> Simulation::shareFacilitiesOptions() {
+    if (!sharedFacilitiesOptions) {
+        sharedFacilitiesOptions = make_shared<const vector<FacilityType>>(facilitiesOptions);
+    }
+    return sharedFacilitiesOptions;
+}
+
 // Start the simulation
 void Simulation::open() {
     isRunning = true;
@@ -0,0 +1,284 @@
+#include "SimulationImage.h"
+#include "ActionLog.h"
+#include <cstdio>
+#include <cstring>
+#include <climits>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ********************************************** SimulationImage ***************************************************** //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+const uint32_t SimulationImage::version;
+const char SimulationImage::magic[8] = {'S', 'I', 'M', 'I', 'M', 'A', 'G', 'E'};
+const size_t SimulationImage::headerSize;
+
+// FNV-1a, enough to tell a truncated or damaged image from a good one
+uint64_t SimulationImage::checksum(const unsigned char *bytes, const size_t size) {
+    uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Reads a whole image file into memory as it is, header and checksum included, leaving the checks to ImageReader
+vector<unsigned char> SimulationImage::readFile(const string &path) {
+    int file = ::open(path.c_str(), O_RDONLY);
+    struct stat status;
+    if (file < 0 || ::fstat(file, &status) != 0) {
+        if (file >= 0) ::close(file);
+        throw runtime_error("Unable to open image");
+    }
+    vector<unsigned char> bytes(static_cast<size_t>(status.st_size));
+    size_t numOfRead = 0;
+    while (numOfRead < bytes.size()) {
+        ssize_t count = ::read(file, bytes.data() + numOfRead, bytes.size() - numOfRead);
+        if (count <= 0) {
+            ::close(file);
+            throw runtime_error("Unable to open image");
+        }
+        numOfRead += static_cast<size_t>(count);
+    }
+    ::close(file);
+    return bytes;
+}
+
+// The header's fixed-size little-endian numbers
+namespace {
+
+void appendFixed(vector<unsigned char> &bytes, uint64_t value, const size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        bytes.push_back(static_cast<unsigned char>(value & 0xff));
+        value >>= 8;
+    }
+}
+
+uint64_t readFixed(const unsigned char *bytes, const size_t size) {
+    uint64_t value = 0;
+    for (size_t i = size; i > 0; i--) {
+        value = (value << 8) | bytes[i - 1];
+    }
+    return value;
+}
+
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ************************************************ ImageWriter ******************************************************* //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Rule of 3 used here, but the writer can't be copied - Nothing needs to copy it.
+
+// Constructor: an empty body
+ImageWriter::ImageWriter() : body(), strings(nullptr) {}
+
+// Constructor: an empty body, with strings interned in a pool
+ImageWriter::ImageWriter(StringPool &strings) : body(), strings(&strings) {}
+
+// Appends an unsigned number, 7 bits a byte, low bits first
+void ImageWriter::writeSize(size_t value) {
+    while (value >= 0x80) {
+        body.push_back(static_cast<unsigned char>(value | 0x80));
+        value >>= 7;
+    }
+    body.push_back(static_cast<unsigned char>(value));
+}
+
+// Appends a signed number, zigzag-encoded so small negative numbers stay short
+void ImageWriter::writeInt(const long long value) {
+    unsigned long long zigzag = (static_cast<unsigned long long>(value) << 1) ^ static_cast<unsigned long long>(value >> 63);
+    writeSize(static_cast<size_t>(zigzag));
+}
+
+// Appends a string as its length and its bytes, or as its number in the pool
+void ImageWriter::writeString(const string &value) {
+    if (strings != nullptr) {
+        writeSize(strings->intern(value));
+        return;
+    }
+    writeSize(value.size());
+    body.insert(body.end(), value.begin(), value.end());
+}
+
+// Appends bytes as their length and themselves, never pooled
+void ImageWriter::writeBytes(const vector<unsigned char> &value) {
+    writeSize(value.size());
+    body.insert(body.end(), value.begin(), value.end());
+}
+
+const vector<unsigned char> &ImageWriter::getBody() const {
+    return body;
+}
+
+// Writes the image next to path, flushes it to disk and only then renames it over path,
+// so a crash while saving leaves the previous image at path as it was
+void ImageWriter::writeToFile(const string &path) const {
+    vector<unsigned char> header(SimulationImage::magic, SimulationImage::magic + sizeof(SimulationImage::magic));
+    appendFixed(header, SimulationImage::version, 4);
+    appendFixed(header, body.size(), 8);
+    vector<unsigned char> trailer;
+    appendFixed(trailer, SimulationImage::checksum(body.data(), body.size()), 8);
+
+    string temporaryPath = path + ".tmp";
+    int file = ::open(temporaryPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (file < 0) {
+        throw runtime_error("Unable to write image");
+    }
+    bool written = true;
+    const vector<unsigned char> *parts[] = {&header, &body, &trailer};
+    for (const vector<unsigned char> *part : parts) {
+        size_t offset = 0;
+        while (written && offset < part->size()) {
+            ssize_t count = ::write(file, part->data() + offset, part->size() - offset);
+            written = count > 0;
+            offset += written ? static_cast<size_t>(count) : 0;
+        }
+    }
+    written = written && ::fsync(file) == 0;
+    written = (::close(file) == 0) && written;
+    if (!written || ::rename(temporaryPath.c_str(), path.c_str()) != 0) {
+        ::unlink(temporaryPath.c_str());
+        throw runtime_error("Unable to write image");
+    }
+}
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// ************************************************ ImageReader ******************************************************* //
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+// Rule of 3 used here, but the reader can't be copied - Class owns the mapping.
+
+// Constructor: maps the file and checks its header and checksum
+ImageReader::ImageReader(const string &path) : mapping(nullptr), mappingSize(0), position(nullptr), end(nullptr), strings(nullptr) {
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) {
+        throw runtime_error("Unable to open image");
+    }
+    struct stat status;
+    if (::fstat(file, &status) != 0 || static_cast<size_t>(status.st_size) < SimulationImage::headerSize + 8) {
+        ::close(file);
+        throw runtime_error("Invalid image");
+    }
+    mappingSize = static_cast<size_t>(status.st_size);
+    mapping = ::mmap(nullptr, mappingSize, PROT_READ, MAP_PRIVATE, file, 0);
+    ::close(file); // The mapping keeps the file's pages
+    if (mapping == MAP_FAILED) {
+        mapping = nullptr;
+        throw runtime_error("Unable to open image");
+    }
+    try {
+        open(static_cast<const unsigned char*>(mapping), mappingSize);
+    } catch (...) {
+        ::munmap(mapping, mappingSize);
+        throw;
+    }
+}
+
+// Constructor: checks the header and checksum of a whole image already in memory, as read by SimulationImage::readFile
+ImageReader::ImageReader(const vector<unsigned char> &image)
+    : mapping(nullptr), mappingSize(0), position(nullptr), end(nullptr), strings(nullptr) {
+    open(image.data(), image.size());
+}
+
+// Constructor: reads the bytes from begin to end
+ImageReader::ImageReader(const unsigned char *begin, const unsigned char *end)
+    : mapping(nullptr), mappingSize(0), position(begin), end(end), strings(nullptr) {}
+
+// Constructor: reads the bytes from begin to end, with strings interned in a pool
+ImageReader::ImageReader(const unsigned char *begin, const unsigned char *end, const StringPool &strings)
+    : mapping(nullptr), mappingSize(0), position(begin), end(end), strings(&strings) {}
+
+// Destructor
+ImageReader::~ImageReader() {
+    if (mapping != nullptr) {
+        ::munmap(mapping, mappingSize);
+    }
+}
+
+// Reads an unsigned number written by ImageWriter::writeSize
+size_t ImageReader::readSize() {
+    size_t value = 0;
+    for (int shift = 0; shift < 64; shift += 7) {
+        if (position == end) {
+            throw runtime_error("Invalid image");
+        }
+        unsigned char byte = *position++;
+        value |= static_cast<size_t>(byte & 0x7f) << shift;
+        if ((byte & 0x80) == 0) {
+            return value;
+        }
+    }
+    throw runtime_error("Invalid image");
+}
+
+size_t ImageReader::readSize(const size_t limit) {
+    size_t value = readSize();
+    if (value >= limit) {
+        throw runtime_error("Invalid image");
+    }
+    return value;
+}
+
+// Reads a signed number written by ImageWriter::writeInt
+long long ImageReader::readLong() {
+    unsigned long long zigzag = readSize();
+    return static_cast<long long>(zigzag >> 1) ^ -static_cast<long long>(zigzag & 1);
+}
+
+int ImageReader::readInt() {
+    long long value = readLong();
+    if (value < INT_MIN || value > INT_MAX) {
+        throw runtime_error("Invalid image");
+    }
+    return static_cast<int>(value);
+}
+
+// Reads a string written by ImageWriter::writeString
+string ImageReader::readString() {
+    if (strings != nullptr) {
+        return strings->get(readSize(strings->size()));
+    }
+    size_t size = readSize(static_cast<size_t>(end - position) + 1);
+    string value(reinterpret_cast<const char*>(position), size);
+    position += size;
+    return value;
+}
+
+// Reads bytes written by ImageWriter::writeBytes
+vector<unsigned char> ImageReader::readBytes() {
+    size_t size = readSize(static_cast<size_t>(end - position) + 1);
+    vector<unsigned char> value(position, position + size);
+    position += size;
+    return value;
+}
+
+// Whether the whole body was read
+bool ImageReader::atEnd() const {
+    return position == end;
+}
+
+const unsigned char *ImageReader::getPosition() const {
+    return position;
+}
+
+// Checks the header and the checksum of the image in bytes, and sets the body up to be read
+void ImageReader::open(const unsigned char *bytes, const size_t size) {
+    if (size < SimulationImage::headerSize + 8 || memcmp(bytes, SimulationImage::magic, sizeof(SimulationImage::magic)) != 0) {
+        throw runtime_error("Invalid image");
+    }
+    if (readFixed(bytes + 8, 4) != SimulationImage::version) {
+        throw runtime_error("Unsupported image version");
+    }
+    uint64_t bodySize = readFixed(bytes + 12, 8);
+    if (bodySize != size - SimulationImage::headerSize - 8
+        || readFixed(bytes + SimulationImage::headerSize + bodySize, 8) != SimulationImage::checksum(bytes + SimulationImage::headerSize, bodySize)) {
+        throw runtime_error("Invalid image");
+    }
+    position = bytes + SimulationImage::headerSize;
+    end = position + bodySize;
+}
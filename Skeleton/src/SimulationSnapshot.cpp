@@ -0,0 +1,77 @@
+#include "SimulationSnapshot.h"
+#include "Simulation.h"
+#include "Action.h"
+
+// No rule of 3 needed - Every part is shared, and released by its last owner.
+
+// Constructor: shares the simulation's current state
+SimulationSnapshot::SimulationSnapshot(Simulation &simulation)
+    : planCounter(simulation.planCounter), facilitiesOptions(simulation.shareFacilitiesOptions()), settlements(simulation.settlements),
+      plans(simulation.plans), actionsLog(simulation.actionsLog), replayBase() {}
+
+// Constructor: shares only the simulation's log, to replay it from replayBase (a full snapshot it starts with)
+SimulationSnapshot::SimulationSnapshot(Simulation &simulation, const shared_ptr<const SimulationSnapshot> &replayBase)
+    : planCounter(simulation.planCounter), facilitiesOptions(), settlements(), plans(), actionsLog(simulation.actionsLog), replayBase(replayBase) {}
+
+bool SimulationSnapshot::isReplayed() const {
+    return replayBase != nullptr;
+}
+
+// Plan ids are their positions, so the counter is also the number of plans of a replay snapshot
+size_t SimulationSnapshot::getNumOfPlans() const {
+    return planCounter;
+}
+
+size_t SimulationSnapshot::getNumOfActions() const {
+    return actionsLog.size();
+}
+
+// Adds the bytes the snapshot holds to totalBytes, and of those that neither the simulation nor another snapshot
+// shares to uniqueBytes: what dropping the snapshot would free.
+// A replay snapshot holds its base, which only it may hold.
+void SimulationSnapshot::measure(size_t &uniqueBytes, size_t &totalBytes) const {
+    if (replayBase) {
+        size_t baseUniqueBytes = 0, baseTotalBytes = 0;
+        replayBase->measure(baseUniqueBytes, baseTotalBytes);
+        totalBytes += baseTotalBytes;
+        uniqueBytes += replayBase.use_count() == 1 ? baseUniqueBytes : 0;
+    } else {
+        size_t catalogBytes = measureFacilitiesOptions(*facilitiesOptions);
+        totalBytes += catalogBytes;
+        uniqueBytes += facilitiesOptions.use_count() == 1 ? catalogBytes : 0;
+    }
+
+    settlements.measure(true, uniqueBytes, totalBytes, [](const shared_ptr<Settlement> &settlement, bool isUnique, size_t &uniqueBytes, size_t &totalBytes) {
+        size_t settlementBytes = sizeof(Settlement) + settlement->getName().capacity();
+        totalBytes += settlementBytes;
+        uniqueBytes += (isUnique && settlement.use_count() == 1) ? settlementBytes : 0;
+    });
+    plans.measure(uniqueBytes, totalBytes);
+    actionsLog.measure(true, uniqueBytes, totalBytes);
+}
+
+// Bytes this snapshot holds on top of other, a snapshot of the same simulation: what it costs to keep both
+// rather than only other. Only the parts that differ are visited. Both are full snapshots.
+size_t SimulationSnapshot::measureDifference(const SimulationSnapshot &other) const {
+    size_t bytes = 0;
+    if (facilitiesOptions != other.facilitiesOptions) {
+        bytes += measureFacilitiesOptions(*facilitiesOptions);
+    }
+    settlements.measureDifference(other.settlements, bytes, [](const shared_ptr<Settlement> &settlement, const shared_ptr<Settlement> *otherSettlement, size_t &bytes) {
+        if (otherSettlement == nullptr || *otherSettlement != settlement) {
+            bytes += sizeof(Settlement) + settlement->getName().capacity();
+        }
+    });
+    plans.measureDifference(other.plans, bytes);
+    actionsLog.measureDifference(other.actionsLog, bytes);
+    return bytes;
+}
+
+// Bytes of a catalog
+size_t SimulationSnapshot::measureFacilitiesOptions(const vector<FacilityType> &facilitiesOptions) {
+    size_t bytes = facilitiesOptions.capacity() * sizeof(FacilityType);
+    for (const FacilityType &type : facilitiesOptions) {
+        bytes += type.getName().capacity();
+    }
+    return bytes;
+}
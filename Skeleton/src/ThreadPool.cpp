@@ -0,0 +1,96 @@
+#include "ThreadPool.h"
+
+// Rule of 3 deleted - The pool owns running threads.
+
+// Constructor: starts numOfThreads - 1 workers, the caller of run() is the last one
+ThreadPool::ThreadPool(int numOfThreads)
+    : workers(), lock(), wakeUp(), batchDone(), task(nullptr), numOfTasks(0), nextTask(0),
+      unfinishedTasks(0), batch(0), stopping(false), failure(), failedTask(0) {
+    for (int i = 1; i < numOfThreads; i++) {
+        workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+// Destructor: wakes every worker and waits for it to exit
+ThreadPool::~ThreadPool() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+// Number of threads that take part in a batch, including the caller
+int ThreadPool::size() const {
+    return static_cast<int>(workers.size()) + 1;
+}
+
+// Runs task(0) .. task(numOfTasks - 1) across the pool and blocks until all of them are done.
+// If tasks throw, the exception of the lowest task index is rethrown, so failures don't depend on timing.
+void ThreadPool::run(size_t numOfTasks, const function<void(size_t)> &task) {
+    {
+        lock_guard<mutex> guard(lock);
+        this->task = &task;
+        this->numOfTasks = numOfTasks;
+        nextTask = 0;
+        unfinishedTasks = numOfTasks;
+        failure = nullptr;
+        batch++;
+    }
+    wakeUp.notify_all();
+    runTasks();
+
+    unique_lock<mutex> guard(lock);
+    batchDone.wait(guard, [this] { return unfinishedTasks == 0; });
+    this->task = nullptr;
+    if (failure) {
+        exception_ptr error = failure;
+        failure = nullptr;
+        rethrow_exception(error);
+    }
+}
+
+// Worker loop: joins every new batch until the pool is destroyed
+void ThreadPool::work() {
+    unsigned long seenBatch = 0;
+    while (true) {
+        {
+            unique_lock<mutex> guard(lock);
+            wakeUp.wait(guard, [this, seenBatch] { return stopping || batch != seenBatch; });
+            if (stopping) return;
+            seenBatch = batch;
+        }
+        runTasks();
+    }
+}
+
+// Claims and runs tasks of the current batch until none are left
+void ThreadPool::runTasks() {
+    while (true) {
+        size_t index;
+        {
+            lock_guard<mutex> guard(lock);
+            if (nextTask >= numOfTasks) return;
+            index = nextTask++;
+        }
+
+        exception_ptr error = nullptr;
+        try {
+            (*task)(index);
+        } catch (...) {
+            error = current_exception();
+        }
+
+        lock_guard<mutex> guard(lock);
+        if (error && (!failure || index < failedTask)) {
+            failure = error;
+            failedTask = index;
+        }
+        if (--unfinishedTasks == 0) {
+            batchDone.notify_all();
+        }
+    }
+}
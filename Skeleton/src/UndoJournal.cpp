@@ -0,0 +1,74 @@
+#include "UndoJournal.h"
+
+// Rule of 3 used here, but the journal can't be copied - Class owns its entries.
+
+// Constructor: off until given a memory limit
+UndoJournal::UndoJournal() : entries(), memoryLimit(0), memoryUsage(0) {}
+
+// Destructor
+UndoJournal::~UndoJournal() {
+    for (const Entry &entry : entries) {
+        delete entry.snapshot;
+    }
+}
+
+// Sets the bytes the entries may hold, dropping the oldest ones that no longer fit
+void UndoJournal::setMemoryLimit(const size_t memoryLimit) {
+    this->memoryLimit = memoryLimit;
+    while (!entries.empty() && (memoryLimit == 0 || (memoryUsage > memoryLimit && entries.size() > 1))) {
+        dropOldest();
+    }
+}
+
+// Whether state-changing commands are recorded at all
+bool UndoJournal::isEnabled() const {
+    return memoryLimit > 0;
+}
+
+// Keeps the state a simulation was in before a state-changing command
+void UndoJournal::record(const SimulationSnapshot &snapshot) {
+    if (!entries.empty()) {
+        entries.back().bytes = entries.back().snapshot->measureDifference(snapshot);
+        memoryUsage += entries.back().bytes;
+    }
+    entries.push_back({new SimulationSnapshot(snapshot), 0});
+    while (memoryUsage > memoryLimit && entries.size() > 1) {
+        dropOldest();
+    }
+}
+
+// The state before the last numOfCommands recorded commands
+const SimulationSnapshot &UndoJournal::get(const size_t numOfCommands) const {
+    return *entries[entries.size() - numOfCommands].snapshot;
+}
+
+// Forgets the last numOfCommands recorded commands, once the simulation is back in the state before them.
+// The entry before them is measured again against the next one to be recorded.
+void UndoJournal::drop(const size_t numOfCommands) {
+    for (size_t i = 0; i < numOfCommands; i++) {
+        memoryUsage -= entries.back().bytes;
+        delete entries.back().snapshot;
+        entries.pop_back();
+    }
+    if (!entries.empty()) {
+        memoryUsage -= entries.back().bytes;
+        entries.back().bytes = 0;
+    }
+}
+
+// Number of commands that can be undone
+size_t UndoJournal::size() const {
+    return entries.size();
+}
+
+// Bytes held by the entries on top of the simulation
+size_t UndoJournal::getMemoryUsage() const {
+    return memoryUsage;
+}
+
+// Drops the oldest entry
+void UndoJournal::dropOldest() {
+    memoryUsage -= entries.front().bytes;
+    delete entries.front().snapshot;
+    entries.pop_front();
+}
@@ -0,0 +1,231 @@
+#include "WriteAheadLog.h"
+#include "Action.h"
+#include "SimulationImage.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+// Rule of 3 deleted - The log owns its file and its syncing thread.
+
+const uint32_t WriteAheadLog::version;
+const char WriteAheadLog::magic[8] = {'S', 'I', 'M', 'W', 'A', 'L', 'O', 'G'};
+const size_t WriteAheadLog::headerSize;
+
+namespace {
+
+void appendFixed(vector<unsigned char> &bytes, uint64_t value, const size_t size) {
+    for (size_t i = 0; i < size; i++) {
+        bytes.push_back(static_cast<unsigned char>(value & 0xff));
+        value >>= 8;
+    }
+}
+
+uint64_t readFixed(const unsigned char *bytes, const size_t size) {
+    uint64_t value = 0;
+    for (size_t i = size; i > 0; i--) {
+        value = (value << 8) | bytes[i - 1];
+    }
+    return value;
+}
+
+// Writes all the bytes, however many calls it takes
+void writeAll(const int file, const unsigned char *bytes, size_t size) {
+    while (size > 0) {
+        ssize_t written = ::write(file, bytes, size);
+        if (written < 0 && errno == EINTR) continue;
+        if (written <= 0) {
+            throw runtime_error("Unable to write the write-ahead log");
+        }
+        bytes += written;
+        size -= static_cast<size_t>(written);
+    }
+}
+
+}
+
+// Constructor: opens the log at path, creating it if there is none. Its records are read by recover(), which comes
+// before the first append.
+WriteAheadLog::WriteAheadLog(const string &path, const size_t syncCount, const int syncInterval)
+    : file(-1), syncCount(syncCount), syncInterval(syncInterval), numOfRecords(0), numOfUnsynced(0), numOfSyncs(0),
+      failed(false), stopping(false), lock(), wakeUp(), syncer() {
+    file = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (file < 0) {
+        throw runtime_error("Unable to open the write-ahead log");
+    }
+    struct stat status;
+    if (::fstat(file, &status) != 0) {
+        ::close(file);
+        throw runtime_error("Unable to open the write-ahead log");
+    }
+
+    unsigned char header[headerSize];
+    if (status.st_size == 0) {
+        vector<unsigned char> bytes(magic, magic + sizeof(magic));
+        appendFixed(bytes, version, 4);
+        try {
+            writeAll(file, bytes.data(), bytes.size());
+        } catch (...) {
+            ::close(file);
+            throw;
+        }
+    } else if (static_cast<size_t>(status.st_size) < headerSize || ::pread(file, header, headerSize, 0) != static_cast<ssize_t>(headerSize)
+               || memcmp(header, magic, sizeof(magic)) != 0 || readFixed(header + sizeof(magic), 4) != version) {
+        ::close(file);
+        throw runtime_error("Invalid write-ahead log");
+    }
+    ::lseek(file, 0, SEEK_END);
+    if (syncInterval > 0) {
+        syncer = thread(&WriteAheadLog::syncPeriodically, this);
+    }
+}
+
+// Destructor: syncs what is left, stops the syncer and closes the file
+WriteAheadLog::~WriteAheadLog() {
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    if (syncer.joinable()) {
+        syncer.join();
+    }
+    ::fdatasync(file);
+    ::close(file);
+}
+
+// Rebuilds each recorded action in order and passes it to execute to act on it again, or, if it was recorded after
+// acting, to log as it went; either takes ownership of it.
+// The records after the last intact one are cut off, then the log is ready for new records.
+// Returns the number of records read.
+size_t WriteAheadLog::recover(const function<void(BaseAction*)> &execute, const function<void(BaseAction*)> &log) {
+    struct stat status;
+    if (::fstat(file, &status) != 0) {
+        throw runtime_error("Unable to read the write-ahead log");
+    }
+    vector<unsigned char> bytes(static_cast<size_t>(status.st_size));
+    size_t numOfRead = 0;
+    while (numOfRead < bytes.size()) {
+        ssize_t read = ::pread(file, bytes.data() + numOfRead, bytes.size() - numOfRead, numOfRead);
+        if (read < 0 && errno == EINTR) continue;
+        if (read <= 0) {
+            throw runtime_error("Unable to read the write-ahead log");
+        }
+        numOfRead += static_cast<size_t>(read);
+    }
+
+    size_t position = headerSize;
+    while (bytes.size() - position >= 8) {
+        const unsigned char *record = bytes.data() + position;
+        size_t bodySize = readFixed(record, 4);
+        if (bodySize > bytes.size() - position - 8 || readFixed(record + 4 + bodySize, 4) != (SimulationImage::checksum(record + 4, bodySize) & 0xffffffff)) {
+            break;
+        }
+        // An intact record that can't be read wasn't written by this version, rather than cut short
+        BaseAction *action = nullptr;
+        try {
+            ImageReader reader(record + 4, record + 4 + bodySize);
+            ActionType type = static_cast<ActionType>(reader.readSize(static_cast<size_t>(ActionType::UNDO) + 1));
+            action = BaseAction::loadAhead(type, reader);
+            if (!action->writesAhead()) {
+                action->status = static_cast<ActionStatus>(reader.readSize(static_cast<size_t>(ActionStatus::ERROR) + 1));
+                action->errorMsg = reader.readString();
+            }
+            if (!reader.atEnd()) {
+                throw runtime_error("Invalid write-ahead log");
+            }
+        } catch (const exception &) {
+            delete action;
+            throw runtime_error("Invalid write-ahead log");
+        }
+        if (action->writesAhead()) {
+            execute(action);
+        } else {
+            log(action);
+        }
+        numOfRecords++;
+        position += bodySize + 8;
+    }
+
+    if (::ftruncate(file, static_cast<off_t>(position)) != 0 || ::lseek(file, 0, SEEK_END) < 0) {
+        throw runtime_error("Unable to write the write-ahead log");
+    }
+    return numOfRecords;
+}
+
+// Writes the record of an action about to act, or that acted if it isn't written ahead. Once syncCount records are
+// unsynced, they are synced: by the syncer if there is one, so the simulation goes on while the disk syncs, or right
+// away otherwise.
+void WriteAheadLog::append(BaseAction &action) {
+    ImageWriter writer;
+    writer.writeSize(static_cast<size_t>(action.getType()));
+    action.saveAhead(writer);
+    if (!action.writesAhead()) {
+        writer.writeSize(static_cast<size_t>(action.status));
+        writer.writeString(action.errorMsg);
+    }
+    const vector<unsigned char> &body = writer.getBody();
+    vector<unsigned char> record;
+    record.reserve(body.size() + 8);
+    appendFixed(record, body.size(), 4);
+    record.insert(record.end(), body.begin(), body.end());
+    appendFixed(record, SimulationImage::checksum(body.data(), body.size()), 4);
+
+    bool isBatchFull = false;
+    {
+        lock_guard<mutex> guard(lock);
+        if (failed) {
+            throw runtime_error("Unable to sync the write-ahead log");
+        }
+        writeAll(file, record.data(), record.size());
+        numOfRecords++;
+        numOfUnsynced++;
+        isBatchFull = numOfUnsynced >= syncCount;
+    }
+    if (isBatchFull && syncer.joinable()) {
+        wakeUp.notify_one();
+    } else if (isBatchFull) {
+        sync();
+    }
+}
+
+// Makes every record written so far outlive the machine. A failure is reported by the next append, since the
+// command of the last record is acted on either way.
+void WriteAheadLog::sync() {
+    {
+        lock_guard<mutex> guard(lock);
+        if (numOfUnsynced == 0) return;
+        numOfUnsynced = 0; // Records written from here on may miss this sync, so they count for the next one
+    }
+    bool synced = ::fdatasync(file) == 0;
+    lock_guard<mutex> guard(lock);
+    numOfSyncs += synced ? 1 : 0;
+    failed = failed || !synced;
+}
+
+size_t WriteAheadLog::getNumOfRecords() const {
+    lock_guard<mutex> guard(lock);
+    return numOfRecords;
+}
+
+size_t WriteAheadLog::getNumOfSyncs() const {
+    lock_guard<mutex> guard(lock);
+    return numOfSyncs;
+}
+
+// Syncer loop: syncs every syncInterval milliseconds while records are unsynced, and as soon as syncCount are,
+// until the log is destroyed
+void WriteAheadLog::syncPeriodically() {
+    unique_lock<mutex> guard(lock);
+    while (!stopping) {
+        wakeUp.wait_for(guard, chrono::milliseconds(syncInterval), [this] { return stopping || numOfUnsynced >= syncCount; });
+        if (stopping || numOfUnsynced == 0) continue;
+        guard.unlock();
+        sync();
+        guard.lock();
+    }
+}
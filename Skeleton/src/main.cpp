@@ -6,22 +6,105 @@
 #include "Action.h"
 #include "Auxiliary.h"
 #include <iostream>
+#include <cstdio>
+#include <cstdlib>
 
 using namespace std;
 
-Simulation* backup = nullptr;
+SimulationSnapshot* backup = nullptr;
+
+const string usage = "usage: simulation <config_path> [--threads <n>] [--fast-forward] [--compact] [--core plans|arrays] [--opt-horizon <n>] [--opt-objective min|sum] [--opt-weights <l>,<e>,<n>] [--resume <image_path>] [--undo-memory <MiB>] [--backup-mode snapshots|replay] [--checkpoint-interval <n>] [--wal <path>] [--wal-sync-count <n>] [--wal-sync-interval <ms>]";
 
 int main(int argc, char** argv){
-    if(argc!=2){
-        cout << "usage: simulation <config_path>" << endl;
+    if(argc<2){
+        cout << usage << endl;
         return 0;
     }
     string configurationFile = argv[1];
+    int numOfThreads = 1;
+    bool fastForward = false;
+    bool compact = false;
+    StepCore stepCore = StepCore::PLANS;
+    int solverHorizon = 0;
+    PlanSolver::Objective solverObjective = PlanSolver::Objective::MIN_SCORE;
+    int solverWeights[3] = {1, 1, 1};
+    string resumePath;
+    size_t undoMemory = 0;
+    BackupMode backupMode = BackupMode::SNAPSHOTS;
+    int checkpointInterval = 0;
+    string walPath;
+    int walSyncCount = 64;
+    int walSyncInterval = 10;
+    for(int i=2; i<argc; i++){
+        string option = argv[i];
+        if(option=="--threads" && i+1<argc && atoi(argv[i+1])>0){
+            numOfThreads = atoi(argv[++i]);
+        } else if(option=="--fast-forward"){
+            fastForward = true;
+        } else if(option=="--compact"){
+            compact = true;
+        } else if(option=="--core" && i+1<argc && (string(argv[i+1])=="plans" || string(argv[i+1])=="arrays")){
+            stepCore = (string(argv[++i])=="plans") ? StepCore::PLANS : StepCore::ARRAYS;
+        } else if(option=="--opt-horizon" && i+1<argc && atoi(argv[i+1])>0){
+            solverHorizon = atoi(argv[++i]);
+        } else if(option=="--opt-objective" && i+1<argc && (string(argv[i+1])=="min" || string(argv[i+1])=="sum")){
+            solverObjective = (string(argv[++i])=="min") ? PlanSolver::Objective::MIN_SCORE : PlanSolver::Objective::WEIGHTED_SUM;
+        } else if(option=="--opt-weights" && i+1<argc && sscanf(argv[i+1], "%d,%d,%d", &solverWeights[0], &solverWeights[1], &solverWeights[2])==3
+                  && solverWeights[0]>=0 && solverWeights[1]>=0 && solverWeights[2]>=0){
+            i++;
+        } else if(option=="--resume" && i+1<argc){
+            resumePath = argv[++i];
+        } else if(option=="--undo-memory" && i+1<argc && atoi(argv[i+1])>0){
+            undoMemory = static_cast<size_t>(atoi(argv[++i])) << 20;
+        } else if(option=="--backup-mode" && i+1<argc && (string(argv[i+1])=="snapshots" || string(argv[i+1])=="replay")){
+            backupMode = (string(argv[++i])=="snapshots") ? BackupMode::SNAPSHOTS : BackupMode::REPLAY;
+        } else if(option=="--checkpoint-interval" && i+1<argc && atoi(argv[i+1])>0){
+            checkpointInterval = atoi(argv[++i]);
+        } else if(option=="--wal" && i+1<argc){
+            walPath = argv[++i];
+        } else if(option=="--wal-sync-count" && i+1<argc && atoi(argv[i+1])>0){
+            walSyncCount = atoi(argv[++i]);
+        } else if(option=="--wal-sync-interval" && i+1<argc && string(argv[i+1]).find_first_not_of("0123456789")==string::npos){
+            walSyncInterval = atoi(argv[++i]);
+        } else {
+            cout << usage << endl;
+            return 0;
+        }
+    }
     Simulation simulation(configurationFile);
+    simulation.setNumOfThreads(numOfThreads);
+    simulation.setFastForward(fastForward);
+    simulation.setCompact(compact);
+    simulation.setStepCore(stepCore);
+    if(solverHorizon>0){
+        simulation.setSolverHorizon(solverHorizon);
+    }
+    simulation.setSolverObjective(solverObjective, solverWeights[0], solverWeights[1], solverWeights[2]);
+    simulation.setUndoMemoryLimit(undoMemory);
+    simulation.setBackupMode(backupMode, checkpointInterval);
+    if(!resumePath.empty()){
+        try{
+            simulation.load(resumePath);
+        } catch(const exception &e){
+            cout << "Unable to resume: " << e.what() << endl;
+            return 1;
+        }
+    }
+    if(!walPath.empty()){
+        try{
+            size_t numOfRecovered = simulation.openWriteAheadLog(walPath, walSyncCount, walSyncInterval);
+            if(numOfRecovered>0){
+                cout << "Recovered " << numOfRecovered << " commands from " << walPath << endl;
+            }
+        } catch(const exception &e){
+            cout << "Unable to recover: " << e.what() << endl;
+            return 1;
+        }
+    }
     simulation.start();
     if(backup!=nullptr){
     	delete backup;
     	backup = nullptr;
     }
     return 0;
-}
\ No newline at end of file
+}
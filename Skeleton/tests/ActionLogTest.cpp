@@ -0,0 +1,96 @@
+#include "Tests.h"
+#include "Action.h"
+#include <algorithm>
+#include <sstream>
+
+namespace {
+
+// The lines of a log command's response, the prompt's output before it aside
+vector<string> linesOf(const string &response) {
+    vector<string> lines;
+    istringstream input(response);
+    string line;
+    while (getline(input, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+// The lines of the full log a query prints: those of its commands and status, from the from-th on, count of them
+vector<string> filterLog(const vector<string> &log, const vector<string> &types, const bool errorsOnly, const size_t from, const size_t count) {
+    vector<string> matching;
+    for (const string &line : log) {
+        string type = line.substr(0, line.find(' '));
+        bool isType = types.empty() || find(types.begin(), types.end(), type) != types.end();
+        bool isError = line.compare(line.rfind(' ') + 1, string::npos, "ERROR") == 0;
+        if (isType && (!errorsOnly || isError)) {
+            matching.push_back(line);
+        }
+    }
+    if (from >= matching.size()) return {};
+    return vector<string>(matching.begin() + from, matching.begin() + from + min(count, matching.size() - from));
+}
+
+}
+
+// A filtered or paged log prints what filtering and paging the full log prints, over a log of many blocks and index
+// chunks: every page, past the end and empty ones included, for several commands at once and for the failed ones
+void testActionLog() {
+    Simulation simulation(configurationPath);
+    vector<string> session = randomSession(24, 1500, {{}, false, false, "", true, {}});
+    for (size_t i = 0; i < session.size(); i += 6) {
+        session.insert(session.begin() + i, "planStatus " + to_string(1000 + i)); // Enough failures to fill index chunks
+    }
+    runCommands(simulation, session);
+    size_t numOfRecords = simulation.getActionsLog().size();
+
+    const vector<vector<string>> typeSets = {{}, {"step"}, {"planStatus", "changePolicy"}, {"plan", "settlement", "facility"}, {"log"}};
+    const vector<size_t> froms = {0, 1, 7, 127, 128, 129, 300, numOfRecords - 1, numOfRecords + 1, numOfRecords + 500};
+    const vector<size_t> counts = {PrintActionsLog::allActions, 0, 1, 5, 128, 129, 1000};
+    vector<string> queries;
+    vector<vector<string>> queryTypes;
+    vector<bool> queryErrorsOnly;
+    vector<pair<size_t, size_t>> queryRanges;
+    for (const vector<string> &types : typeSets) {
+        for (bool errorsOnly : {false, true}) {
+            for (size_t from : froms) {
+                for (size_t count : counts) {
+                    string query = "log";
+                    if (from > 0 || count != PrintActionsLog::allActions) query += " " + to_string(from);
+                    if (count != PrintActionsLog::allActions) query += " " + to_string(count);
+                    for (const string &type : types) {
+                        query += " --type=" + type;
+                    }
+                    if (errorsOnly) query += " --errors";
+                    queries.push_back(query);
+                    queryTypes.push_back(types);
+                    queryErrorsOnly.push_back(errorsOnly);
+                    queryRanges.push_back({from, count});
+                }
+            }
+        }
+    }
+
+    // Each query is followed by the full log, which ends with the query itself
+    vector<string> commands;
+    for (const string &query : queries) {
+        commands.push_back(query);
+        commands.push_back("log");
+    }
+    vector<string> responses = runCommands(simulation, commands);
+    check(responses.size() == commands.size(), "the queries run to the end");
+    size_t numOfSame = 0, numOfEmpty = 0;
+    vector<string> log;
+    for (size_t i = 0; i < queries.size() && 2 * i + 1 < responses.size(); i++) {
+        log = linesOf(responses[2 * i + 1]);
+        log.pop_back();
+        vector<string> expected = filterLog(log, queryTypes[i], queryErrorsOnly[i], queryRanges[i].first, queryRanges[i].second);
+        bool isSame = linesOf(responses[2 * i]) == expected;
+        check(isSame, "'" + queries[i] + "' prints the full log filtered and paged");
+        numOfSame += isSame ? 1 : 0;
+        numOfEmpty += expected.empty() ? 1 : 0;
+    }
+    check(numOfSame > numOfEmpty, "most queries print something");
+    check(filterLog(log, {"step"}, false, 0, PrintActionsLog::allActions).size() > 2 * 128, "the log indexes steps in several chunks");
+    check(filterLog(log, {"planStatus"}, true, 0, PrintActionsLog::allActions).size() > 2 * 128, "the log indexes failures in several chunks");
+}
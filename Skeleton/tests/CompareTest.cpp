@@ -0,0 +1,58 @@
+#include "Tests.h"
+#include <sstream>
+
+namespace {
+
+// The scores planStatus prints, in the order compare prints them
+vector<int> statusScores(const string &status) {
+    vector<int> scores;
+    for (const string name : {"LifeQualityScore: ", "EconomyScore: ", "EnvironmentScore: "}) {
+        size_t start = status.find(name);
+        scores.push_back(start == string::npos ? -1 : stoi(status.substr(start + name.size())));
+    }
+    return scores;
+}
+
+// The scores of the current policy's row (marked with a '*') that compare prints, none if it has none
+vector<int> currentScores(const string &comparison) {
+    size_t start = comparison.find("* ");
+    if (start == string::npos) return {};
+    istringstream row(comparison.substr(start + 1, comparison.find('\n', start) - start - 1));
+    vector<int> scores(3, -1);
+    row >> scores[0] >> scores[1] >> scores[2];
+    return scores;
+}
+
+}
+
+// compare forks the plan once per policy and steps the forks, leaving the simulation and its log alone apart from the
+// compare command itself: the current policy's row is what stepping the plan itself prints, on one thread or several
+void testCompare() {
+    const vector<string> setup = {"plan BeitSPL nve", "plan KfarSPL sus", "plan KiryatSPL opt", "settlement Town 1", "plan Town bal",
+                                  "step 13", "changePolicy 0 nve", "facility Clinic 0 2 3 1 1", "step 4"};
+    const int numOfPlans = 6;
+    vector<string> commands = setup;
+    vector<pair<int, int>> compared;
+    for (int numOfSteps : {1, 7, 40}) {
+        for (int planId = 0; planId < numOfPlans; planId++) {
+            string planStatus = "planStatus " + to_string(planId);
+            commands.insert(commands.end(), {planStatus, "log", "compare " + to_string(planId) + " " + to_string(numOfSteps), planStatus,
+                                             "log", "step " + to_string(numOfSteps), planStatus});
+            compared.push_back({planId, numOfSteps});
+        }
+    }
+    for (const vector<string> &options : vector<vector<string>>{{}, {"--threads", "4"}}) {
+        string with = options.empty() ? "" : " with " + options[0] + " " + options[1];
+        vector<string> responses = runSimulation(options, commands);
+        check(responses.size() == commands.size(), "the comparisons" + with + " run to the end");
+        for (size_t i = 0; i < compared.size() && setup.size() + 7 * i + 6 < responses.size(); i++) {
+            const string *response = &responses[setup.size() + 7 * i];
+            string description = "compare " + to_string(compared[i].first) + " " + to_string(compared[i].second) + with;
+            check(response[0] == response[3], description + " leaves the plan as it was");
+            check(response[1] + "log COMPLETED\n" + commands[setup.size() + 7 * i + 2] + " COMPLETED\n"
+                  + commands[setup.size() + 7 * i] + " COMPLETED\n" == response[4], description + " only logs itself");
+            vector<int> scores = currentScores(response[2]);
+            check(!scores.empty() && scores == statusScores(response[6]), description + " scores its policy as stepping the plan does");
+        }
+    }
+}
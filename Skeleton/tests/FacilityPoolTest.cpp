@@ -0,0 +1,32 @@
+#include "Tests.h"
+
+// A plan takes one chunk of its capacity for all the facilities it builds, and so does each copy of it
+void testFacilityPool() {
+    Simulation simulation(configurationPath);
+    size_t numOfPlans = 0;
+    while (simulation.isPlanExists(int(numOfPlans))) numOfPlans++;
+    size_t createdBefore = FacilityPool::getNumOfCreatedFacilities();
+    size_t allocationsBefore = FacilityPool::getNumOfChunkAllocations();
+    runCommands(simulation, {"step 300"});
+    check(FacilityPool::getNumOfCreatedFacilities() - createdBefore > 100 * numOfPlans, "the plans build facilities");
+    check(FacilityPool::getNumOfChunkAllocations() - allocationsBefore == numOfPlans, "each plan allocates a single chunk");
+
+    allocationsBefore = FacilityPool::getNumOfChunkAllocations();
+    Plan copy(simulation.getPlan(0));
+    check(FacilityPool::getNumOfChunkAllocations() - allocationsBefore <= 1, "a copy of a plan allocates a single chunk at most");
+
+    FacilityPool pool(3);
+    vector<FacilityType> catalog = {FacilityType("Type", FacilityCategory::ECONOMY, 1, 1, 1, 1)};
+    Settlement settlement("Village", SettlementType::VILLAGE);
+    allocationsBefore = FacilityPool::getNumOfChunkAllocations();
+    Facility *first = pool.create(catalog, 0, settlement);
+    pool.create(catalog, 0, settlement);
+    pool.create(catalog, 0, settlement);
+    check(FacilityPool::getNumOfChunkAllocations() - allocationsBefore == 1 && pool.getMemoryUsage() >= 3 * sizeof(Facility),
+          "a chunk holds as many facilities as the pool was made for");
+    pool.release(first);
+    check(pool.create(catalog, 0, settlement) == first && FacilityPool::getNumOfChunkAllocations() - allocationsBefore == 1,
+          "a released slot is reused before a new chunk is taken");
+    pool.create(catalog, 0, settlement);
+    check(FacilityPool::getNumOfChunkAllocations() - allocationsBefore == 2 && pool.size() == 4, "a full chunk takes another");
+}
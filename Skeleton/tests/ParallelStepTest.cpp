@@ -0,0 +1,58 @@
+#include "Tests.h"
+#include "Action.h"
+
+namespace {
+
+const vector<string> policies = {"nve", "bal", "eco", "sus", "opt"};
+
+// The configuration's simulation with numOfPlans more plans, on new settlements of every type, the policies taking turns
+Simulation *makeSimulation(const int numOfPlans) {
+    Simulation *simulation = new Simulation(configurationPath);
+    for (int i = 0; i < numOfPlans; i++) {
+        string settlementName = "Settlement" + to_string(i);
+        AddSettlement(settlementName, static_cast<SettlementType>(i % 3)).act(*simulation);
+        AddPlan(settlementName, policies[i % policies.size()]).act(*simulation);
+    }
+    return simulation;
+}
+
+// Every plan as planStatus prints it
+vector<string> planStatuses(const Simulation &simulation) {
+    vector<string> statuses;
+    for (int id = 0; simulation.isPlanExists(id); id++) {
+        statuses.push_back(simulation.getPlan(id).toString());
+    }
+    return statuses;
+}
+
+// The plans after steps of the given lengths, stepped with the given threads, core and fast-forwarding
+vector<string> stepPlans(const int numOfThreads, const StepCore stepCore, const bool fastForward) {
+    Simulation *simulation = makeSimulation(60);
+    simulation->setNumOfThreads(numOfThreads);
+    simulation->setStepCore(stepCore);
+    simulation->setFastForward(fastForward);
+    for (int numOfSteps : {1, 37, 100}) {
+        simulation->step(numOfSteps);
+    }
+    vector<string> statuses = planStatuses(*simulation);
+    delete simulation;
+    return statuses;
+}
+
+}
+
+// Plans stepped on several threads end up exactly where the same plans stepped one after the other do, with either
+// stepping core, with and without fast-forwarding
+void testParallelStep() {
+    for (StepCore stepCore : {StepCore::PLANS, StepCore::ARRAYS}) {
+        for (bool fastForward : {false, true}) {
+            string description = string(stepCore == StepCore::PLANS ? "plans" : "arrays") + " core" + (fastForward ? " fast-forwarding" : "");
+            vector<string> serial = stepPlans(1, stepCore, fastForward);
+            check(serial.size() == 62, description + ": the plans are added");
+            for (int numOfThreads : {2, 3, 8}) {
+                check(stepPlans(numOfThreads, stepCore, fastForward) == serial,
+                      description + " on " + to_string(numOfThreads) + " threads steps the plans as one thread does");
+            }
+        }
+    }
+}
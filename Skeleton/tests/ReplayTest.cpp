@@ -0,0 +1,53 @@
+#include "Tests.h"
+#include <unistd.h>
+
+namespace {
+
+// A session that changes the simulation, backs it up, restores it, undoes and prints it. Images are saved to and loaded
+// from the given path, so the state a replay starts from is sometimes the configuration, sometimes an image.
+vector<string> replayedSession(const unsigned int seed, const string &imagePath) {
+    vector<string> commands = randomSession(seed, 150, {{"", "a", "b"}, false, true, imagePath, true, {}});
+    for (int i = 0; i < 8; i++) {
+        commands.push_back("planStatus " + to_string(i));
+    }
+    return commands;
+}
+
+}
+
+// Backups rebuilt by replaying the log restore the same state as snapshots do: a session prints the same, command by
+// command, in either backup mode, whether replays start from the configuration, an image or a checkpoint
+void testReplay() {
+    string directory = makeTemporaryDirectory();
+    string imagePath = directory + "/replayed.img";
+    const vector<vector<string>> baseOptions = {{}, {"--undo-memory", "16"}};
+    const vector<vector<string>> replayOptions = {{"--backup-mode", "replay"}, {"--backup-mode", "replay", "--checkpoint-interval", "4"}};
+    for (unsigned int seed = 1; seed <= 4; seed++) {
+        vector<string> commands = replayedSession(seed, imagePath);
+        for (const vector<string> &base : baseOptions) {
+            string description = "seed " + to_string(seed) + (base.empty() ? "" : " " + base[0] + " " + base[1]);
+            vector<string> expected = runSimulation(base, commands);
+            ::unlink(imagePath.c_str());
+            check(expected.size() == commands.size(), description + ": the session runs to the end with snapshots");
+            size_t numOfRestores = 0;
+            for (size_t i = 0; i < commands.size() && i < expected.size(); i++) {
+                numOfRestores += commands[i].compare(0, 7, "restore") == 0 && expected[i].empty() ? 1 : 0;
+            }
+            check(numOfRestores > 0, description + ": the session restores backups");
+            for (const vector<string> &replay : replayOptions) {
+                vector<string> options = base;
+                options.insert(options.end(), replay.begin(), replay.end());
+                vector<string> responses = runSimulation(options, commands);
+                ::unlink(imagePath.c_str());
+                size_t firstDifference = 0;
+                while (firstDifference < min(responses.size(), expected.size()) && responses[firstDifference] == expected[firstDifference]) {
+                    firstDifference++;
+                }
+                check(responses == expected, description + (replay.size() > 2 ? " " + replay[2] + " " + replay[3] : "")
+                                             + ": replayed backups print what snapshots do (first difference at '"
+                                             + (firstDifference < commands.size() ? commands[firstDifference] : string("the end")) + "')");
+            }
+        }
+    }
+    ::rmdir(directory.c_str());
+}
@@ -0,0 +1,128 @@
+#include "Tests.h"
+#include "ScoreIndex.h"
+#include <climits>
+#include <random>
+
+namespace {
+
+// A catalog of random types, whose scores are drawn from [0, maxImpact]: small impacts make many ties
+vector<FacilityType> randomCatalog(mt19937 &random, const size_t size, const int maxImpact) {
+    vector<FacilityType> catalog;
+    for (size_t i = 0; i < size; i++) {
+        catalog.emplace_back("Type" + to_string(i), FacilityCategory::ECONOMY, 1, static_cast<int>(random() % (maxImpact + 1)),
+                             static_cast<int>(random() % (maxImpact + 1)), static_cast<int>(random() % (maxImpact + 1)));
+    }
+    return catalog;
+}
+
+// BalancedSelection's own loop: the first type with the smallest range once added to the scores
+int scanCatalog(const vector<FacilityType> &catalog, const int lifeQualityScore, const int economyScore, const int environmentScore) {
+    int bestIndex = -1;
+    int smallestRange = INT_MAX;
+    for (size_t i = 0; i < catalog.size(); i++) {
+        int lifeQuality = catalog[i].getLifeQualityScore() + lifeQualityScore;
+        int economy = catalog[i].getEconomyScore() + economyScore;
+        int environment = catalog[i].getEnvironmentScore() + environmentScore;
+        int range = max({lifeQuality, economy, environment}) - min({lifeQuality, economy, environment});
+        if (range < smallestRange) {
+            smallestRange = range;
+            bestIndex = static_cast<int>(i);
+        }
+    }
+    return bestIndex;
+}
+
+// Checks the decisions remembered for a catalog of 100 types: translated scores are the same question, a shard
+// full of decisions drops the least recently used one, and a new type forgets them all
+void checkDecisionCache(mt19937 &random) {
+    vector<FacilityType> catalog = randomCatalog(random, 100, 1000);
+    ScoreIndex index;
+    index.update(catalog);
+    bool isSame = true;
+    size_t hitsBefore = index.getNumOfCacheHits();
+    for (int i = 0; i < 200; i++) {
+        int lifeQuality = static_cast<int>(random() % 100000), economy = static_cast<int>(random() % 100000);
+        int environment = static_cast<int>(random() % 100000), translation = static_cast<int>(random() % 100000);
+        isSame = isSame && index.findMostBalanced(lifeQuality, economy, environment) == scanCatalog(catalog, lifeQuality, economy, environment);
+        isSame = isSame && index.findMostBalanced(lifeQuality + translation, economy + translation, environment + translation)
+                           == scanCatalog(catalog, lifeQuality + translation, economy + translation, environment + translation);
+    }
+    check(isSame, "a remembered decision is the first most balanced type");
+    check(index.getNumOfCacheHits() - hitsBefore >= 200, "scores translated by the same amount hit the decision they share");
+
+    // The differences (0, i) of the scores (0, 0, i), spread over the shards. Fewer than a shard holds are all kept;
+    // twice as many as all the shards hold drop all but the most recent ones, and the decision used all along.
+    ScoreIndex evicting;
+    evicting.update(catalog);
+    const int numOfKept = 1 << 12, numOfDropping = 2 * 16 * (1 << 12);
+    for (int i = 0; i < numOfKept; i++) {
+        evicting.findMostBalanced(0, 0, i);
+    }
+    size_t missesBefore = evicting.getNumOfCacheMisses();
+    for (int i = 0; i < numOfKept; i++) {
+        evicting.findMostBalanced(0, 0, i);
+    }
+    check(evicting.getNumOfCacheMisses() == missesBefore, "a shard keeps up to 4096 decisions");
+    for (int i = numOfKept; i < numOfDropping; i++) {
+        evicting.findMostBalanced(0, 0, i);
+        if (i % 256 == 0) {
+            evicting.findMostBalanced(0, 0, 0);
+        }
+    }
+    missesBefore = evicting.getNumOfCacheMisses();
+    evicting.findMostBalanced(0, 0, 0);
+    check(evicting.getNumOfCacheMisses() == missesBefore, "a decision used all along is kept");
+    evicting.findMostBalanced(0, 0, 1);
+    check(evicting.getNumOfCacheMisses() == missesBefore + 1, "the least recently used decision is dropped from a full shard");
+    missesBefore = evicting.getNumOfCacheMisses();
+    evicting.findMostBalanced(0, 0, numOfDropping - 1);
+    check(evicting.getNumOfCacheMisses() == missesBefore, "the most recent decisions are kept");
+
+    // No type balances (0, 0, 100000) out, up to the one added, which is then the answer
+    index.findMostBalanced(0, 0, 100000);
+    catalog.emplace_back("Balancing", FacilityCategory::ECONOMY, 1, 100000, 100000, 0);
+    index.update(catalog);
+    missesBefore = index.getNumOfCacheMisses();
+    int found = index.findMostBalanced(0, 0, 100000);
+    check(index.getNumOfCacheMisses() == missesBefore + 1 && found == static_cast<int>(catalog.size()) - 1
+          && found == scanCatalog(catalog, 0, 0, 100000), "a new type forgets the decisions made without it");
+}
+
+}
+
+// Every way of finding the most balanced type - the scalar, SSE4.1 and AVX2 scans and the tree - picks the type the
+// plain loop picks, ties included, on catalogs on both sides of the sizes where the simulation switches between them.
+// The decisions it remembers are the ones it would make again.
+void testScoreIndex() {
+    const vector<pair<ScoreIndex::Method, string>> methods = {
+        {ScoreIndex::Method::AUTOMATIC, "automatic"}, {ScoreIndex::Method::SCAN_SCALAR, "scalar scan"},
+        {ScoreIndex::Method::SCAN_SSE41, "SSE4.1 scan"}, {ScoreIndex::Method::SCAN_AVX2, "AVX2 scan"},
+        {ScoreIndex::Method::TREE, "tree"}};
+    const vector<size_t> sizes = {1, 3, 7, 8, 9, 63, 64, 65, 1000, 2047, 2048, 2049, 5000};
+    const vector<int> maxImpacts = {3, 1000};
+    mt19937 random(12);
+    for (size_t size : sizes) {
+        for (int maxImpact : maxImpacts) {
+            vector<FacilityType> catalog = randomCatalog(random, size, maxImpact);
+            vector<vector<int>> queries;
+            for (int i = 0; i < 200; i++) {
+                int spread = i % 2 == 0 ? 10 : 100000;
+                queries.push_back({static_cast<int>(random() % spread), static_cast<int>(random() % spread), static_cast<int>(random() % spread)});
+            }
+            for (const pair<ScoreIndex::Method, string> &method : methods) {
+                if (!ScoreIndex::isSupported(method.first)) continue;
+                ScoreIndex index;
+                index.update(catalog, method.first);
+                bool isSame = true;
+                for (const vector<int> &query : queries) {
+                    isSame = isSame && index.findMostBalanced(query[0], query[1], query[2]) == scanCatalog(catalog, query[0], query[1], query[2]);
+                }
+                check(isSame, "the " + method.second + " picks the first most balanced of " + to_string(size) + " types with scores up to "
+                              + to_string(maxImpact));
+            }
+        }
+    }
+    check(ScoreIndex::isSupported(ScoreIndex::Method::SCAN_SCALAR) && ScoreIndex::isSupported(ScoreIndex::Method::TREE),
+          "the scalar scan and the tree run everywhere");
+    checkDecisionCache(random);
+}
@@ -0,0 +1,113 @@
+#include "Tests.h"
+#include <functional>
+#include <unistd.h>
+
+namespace {
+
+// Writes an image of one village with a plan of the given policy, the policy's state written by savePolicy, and a
+// facility under construction with timeLeft steps to go. The catalog has a type of each category, costing 3.
+void writeImage(const string &path, const string &policyName, const function<void(ImageWriter&)> &savePolicy, const int timeLeft) {
+    ImageWriter writer;
+    writer.writeInt(1); // Plans made
+    writer.writeSize(3);
+    for (size_t category = 0; category < 3; category++) {
+        writer.writeString("Type" + to_string(category));
+        writer.writeSize(category);
+        writer.writeInt(3);
+        writer.writeInt(1);
+        writer.writeInt(1);
+        writer.writeInt(1);
+    }
+    writer.writeSize(1);
+    writer.writeString("Village");
+    writer.writeSize(0);
+
+    writer.writeSize(1);
+    writer.writeInt(0);
+    writer.writeSize(0);
+    writer.writeString(policyName);
+    savePolicy(writer);
+    writer.writeSize(1); // BUSY
+    writer.writeInt(0);
+    writer.writeInt(0);
+    writer.writeInt(0);
+    writer.writeSize(1);
+    writer.writeSize(0);
+    writer.writeInt(timeLeft);
+    writer.writeSize(0); // Not compact
+    writer.writeSize(0);
+    writer.writeSize(0);
+
+    writer.writeSize(0); // Log
+    writer.writeToFile(path);
+}
+
+// What loading the image prints
+string loadResponse(const string &path) {
+    Simulation simulation(configurationPath);
+    return runCommands(simulation, {"load " + path}).at(0);
+}
+
+// The state of an "opt" policy: the capacity, scores, constructions, planned selections and last selection
+function<void(ImageWriter&)> optimalState(const size_t capacity, const int plannedIndex, const int constructionTimeLeft) {
+    return [=](ImageWriter &writer) {
+        writer.writeSize(capacity);
+        writer.writeInt(0);
+        writer.writeInt(0);
+        writer.writeInt(0);
+        writer.writeSize(1);
+        writer.writeInt(0);
+        writer.writeInt(constructionTimeLeft);
+        writer.writeSize(1);
+        writer.writeInt(plannedIndex);
+        writer.writeInt(0);
+    };
+}
+
+}
+
+// Images whose values are out of range for their catalog or their plans are refused like damaged ones
+void testSimulationImage() {
+    string directory = makeTemporaryDirectory();
+    string path = directory + "/checked.img";
+    auto naiveState = [](const int lastSelectedIndex) {
+        return [=](ImageWriter &writer) { writer.writeInt(lastSelectedIndex); };
+    };
+    auto economyState = [](const int lastSelectedIndex, const size_t lastSelectedPosition) {
+        return [=](ImageWriter &writer) {
+            writer.writeInt(lastSelectedIndex);
+            writer.writeSize(lastSelectedPosition);
+        };
+    };
+    const string loaded = "";
+    const string refused = "Error: Invalid image\n";
+
+    writeImage(path, "nve", naiveState(2), 3);
+    check(loadResponse(path) == loaded, "an image in range loads");
+    writeImage(path, "nve", naiveState(3), 3);
+    check(loadResponse(path) == refused, "a last selection past the catalog is refused");
+    writeImage(path, "nve", naiveState(-2), 3);
+    check(loadResponse(path) == refused, "a negative last selection is refused");
+
+    writeImage(path, "eco", economyState(1, 0), 1);
+    check(loadResponse(path) == loaded, "a category position in range loads");
+    writeImage(path, "eco", economyState(1, 1), 1);
+    check(loadResponse(path) == refused, "a category position past the category's types is refused");
+
+    writeImage(path, "nve", naiveState(0), 4);
+    check(loadResponse(path) == refused, "a facility with more time left than its cost is refused");
+    writeImage(path, "nve", naiveState(0), 0);
+    check(loadResponse(path) == refused, "a facility under construction with no time left is refused");
+
+    writeImage(path, "opt", optimalState(1, 2, 3), 3);
+    check(loadResponse(path) == loaded, "an opt state in range loads");
+    writeImage(path, "opt", optimalState(2, 2, 3), 3);
+    check(loadResponse(path) == refused, "an opt capacity other than the plan's is refused");
+    writeImage(path, "opt", optimalState(1, 3, 3), 3);
+    check(loadResponse(path) == refused, "a planned selection past the catalog is refused");
+    writeImage(path, "opt", optimalState(1, 2, 4), 3);
+    check(loadResponse(path) == refused, "a planned construction with more time left than its cost is refused");
+
+    ::unlink(path.c_str());
+    ::rmdir(directory.c_str());
+}
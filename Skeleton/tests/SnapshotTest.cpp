@@ -0,0 +1,80 @@
+#include "Tests.h"
+#include <map>
+
+namespace {
+
+const int maxNumOfPlans = 12;
+const vector<string> policies = {"nve", "bal", "eco", "sus"}; // As plan and changePolicy name them
+
+// Every plan's status, including plans that don't exist yet
+vector<string> probe() {
+    vector<string> commands;
+    for (int i = 0; i < maxNumOfPlans; i++) {
+        commands.push_back("planStatus " + to_string(i));
+    }
+    return commands;
+}
+
+// Checks that each restore of a named snapshot brings back the plans as they were when it was taken, whatever
+// changed in between. Returns the responses.
+vector<string> checkRestores(const vector<string> &options, const vector<string> &commands, const string &description) {
+    vector<string> responses = runSimulation(options, commands);
+    if (responses.size() != commands.size()) {
+        check(false, description + ": the session ends early");
+        return responses;
+    }
+    map<string, vector<string>> backedUp;
+    size_t numOfRestores = 0;
+    size_t numOfProbes = probe().size();
+    for (size_t i = 0; i + numOfProbes < commands.size(); i++) {
+        bool isBackup = commands[i].compare(0, 7, "backup ") == 0;
+        bool isRestore = commands[i].compare(0, 8, "restore ") == 0;
+        if (!isBackup && !isRestore) continue;
+        string name = commands[i].substr(isBackup ? 7 : 8);
+        vector<string> status(responses.begin() + i + 1, responses.begin() + i + 1 + numOfProbes);
+        if (isBackup) {
+            backedUp[name] = status;
+        } else if (responses[i].empty() && backedUp.count(name) == 1) {
+            check(status == backedUp[name], description + ": '" + commands[i] + "' (command " + to_string(i) + ") restores the plans");
+            numOfRestores++;
+        }
+    }
+    check(numOfRestores > 0, description + ": the session restores snapshots");
+    return responses;
+}
+
+}
+
+// Named snapshots share what they have in common with the simulation and with each other, copying only what changes:
+// a restore brings back exactly what was there at the backup, with every stepping option. Fast-forwarding the plans'
+// cycles and stepping on several threads or through the arrays core don't change what a session prints.
+void testSnapshots() {
+    const vector<vector<string>> optionSets = {{}, {"--fast-forward"}, {"--threads", "4"}, {"--core", "arrays"},
+                                               {"--threads", "3", "--fast-forward"}};
+    for (unsigned int seed = 1; seed <= 3; seed++) {
+        vector<string> commands = randomSession(seed, 120, {{"a", "b", "c"}, true, false, "", false, probe()});
+        vector<string> expected = checkRestores({}, commands, "seed " + to_string(seed));
+        for (const string &policy : policies) {
+            size_t numOfPlans = 0;
+            for (size_t i = 0; i < commands.size() && i < expected.size(); i++) {
+                bool isPlan = commands[i].compare(0, 5, "plan ") == 0 && commands[i].substr(commands[i].rfind(' ') + 1) == policy;
+                numOfPlans += isPlan && expected[i].empty() ? 1 : 0;
+            }
+            check(numOfPlans > 0, "seed " + to_string(seed) + ": the session creates " + policy + " plans");
+        }
+        for (size_t i = 1; i < optionSets.size(); i++) {
+            string description = "seed " + to_string(seed) + " with " + optionSets[i][0];
+            check(checkRestores(optionSets[i], commands, description) == expected, description + " prints the same");
+        }
+        checkRestores({"--compact"}, commands, "seed " + to_string(seed) + " with --compact");
+    }
+
+    // Printing and comparing plans only reads them, so the snapshot still shares all of them
+    vector<string> responses = runSimulation({}, {"step 3", "backup a", "snapshots", "planStatus 0", "compare 1 5", "snapshots"});
+    auto uniqueBytes = [](const string &listed) {
+        size_t start = listed.find("UniqueBytes: ");
+        return start == string::npos ? string() : listed.substr(start, listed.find('\n', start) - start);
+    };
+    check(responses.size() == 6 && uniqueBytes(responses[2]) == "UniqueBytes: 0" && uniqueBytes(responses[5]) == "UniqueBytes: 0",
+          "reading the plans copies nothing out of a snapshot");
+}
@@ -0,0 +1,287 @@
+#include "Tests.h"
+#include "Action.h"
+#include <cerrno>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <fcntl.h>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <utility>
+
+SimulationSnapshot *backup = nullptr; // The backup the actions share, as main.cpp defines it for bin/simulation
+const char *const configurationPath = "config_file.txt";
+
+namespace {
+
+const char *const simulationPath = "bin/simulation";
+const string prompt = "Enter an action: ";
+
+size_t numOfChecks = 0;
+size_t numOfFailures = 0;
+
+// Starts bin/simulation with its input and output piped to the returned descriptors
+pid_t startSimulation(const vector<string> &options, int &input, int &output) {
+    int inputPipe[2];
+    int outputPipe[2];
+    if (::pipe(inputPipe) != 0 || ::pipe(outputPipe) != 0) {
+        throw runtime_error("Unable to start the simulation");
+    }
+    pid_t child = ::fork();
+    if (child < 0) {
+        throw runtime_error("Unable to start the simulation");
+    }
+    if (child == 0) {
+        ::dup2(inputPipe[0], STDIN_FILENO);
+        ::dup2(outputPipe[1], STDOUT_FILENO);
+        ::close(inputPipe[0]);
+        ::close(inputPipe[1]);
+        ::close(outputPipe[0]);
+        ::close(outputPipe[1]);
+        vector<char*> arguments;
+        arguments.push_back(const_cast<char*>(simulationPath));
+        arguments.push_back(const_cast<char*>(configurationPath));
+        for (const string &option : options) {
+            arguments.push_back(const_cast<char*>(option.c_str()));
+        }
+        arguments.push_back(nullptr);
+        ::execv(simulationPath, arguments.data());
+        ::_exit(127);
+    }
+    ::close(inputPipe[0]);
+    ::close(outputPipe[1]);
+    input = inputPipe[1];
+    output = outputPipe[0];
+    return child;
+}
+
+void writeCommands(const int input, const vector<string> &commands) {
+    string text;
+    for (const string &command : commands) {
+        text += command + "\n";
+    }
+    size_t written = 0;
+    while (written < text.size()) {
+        ssize_t count = ::write(input, text.data() + written, text.size() - written);
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) {
+            throw runtime_error("Unable to write to the simulation");
+        }
+        written += static_cast<size_t>(count);
+    }
+}
+
+// Reads the output until it has prompted numOfPrompts times, or until it ends
+string readOutput(const int output, const size_t numOfPrompts) {
+    string text;
+    size_t numOfSeen = 0;
+    size_t searchFrom = 0;
+    char buffer[4096];
+    while (numOfSeen < numOfPrompts) {
+        ssize_t count = ::read(output, buffer, sizeof(buffer));
+        if (count < 0 && errno == EINTR) continue;
+        if (count <= 0) break;
+        text.append(buffer, static_cast<size_t>(count));
+        for (size_t found = text.find(prompt, searchFrom); found != string::npos; found = text.find(prompt, searchFrom)) {
+            numOfSeen++;
+            searchFrom = found + prompt.size();
+        }
+    }
+    return text;
+}
+
+// The output before the first prompt is the start's; each prompt is followed by the response to a command
+vector<string> responsesIn(const string &text, const size_t numOfCommands) {
+    vector<string> responses;
+    size_t begin = text.find(prompt);
+    while (begin != string::npos && responses.size() < numOfCommands) {
+        begin += prompt.size();
+        size_t end = text.find(prompt, begin);
+        responses.push_back(text.substr(begin, end == string::npos ? string::npos : end - begin));
+        begin = end;
+    }
+    return responses;
+}
+
+}
+
+void check(const bool condition, const string &what) {
+    numOfChecks++;
+    if (!condition) {
+        numOfFailures++;
+        cout << "FAILED: " << what << endl;
+    }
+}
+
+vector<string> runSimulation(const vector<string> &options, const vector<string> &commands) {
+    int input = -1;
+    int output = -1;
+    pid_t child = startSimulation(options, input, output);
+    vector<string> lines(commands);
+    lines.push_back("close");
+    writeCommands(input, lines);
+    ::close(input);
+    string text = readOutput(output, SIZE_MAX);
+    ::close(output);
+    ::waitpid(child, nullptr, 0);
+    return responsesIn(text, commands.size());
+}
+
+vector<string> runCommands(Simulation &simulation, const vector<string> &commands) {
+    string text;
+    for (const string &command : commands) {
+        text += command + "\n";
+    }
+    istringstream input(text + "close\n");
+    ostringstream output;
+    streambuf *previousInput = cin.rdbuf(input.rdbuf());
+    streambuf *previousOutput = cout.rdbuf(output.rdbuf());
+    try {
+        simulation.start();
+    } catch (...) {
+        cin.rdbuf(previousInput);
+        cout.rdbuf(previousOutput);
+        throw;
+    }
+    cin.rdbuf(previousInput);
+    cout.rdbuf(previousOutput);
+    return responsesIn(output.str(), commands.size());
+}
+
+void crashSimulation(const vector<string> &options, const vector<string> &commands) {
+    int input = -1;
+    int output = -1;
+    pid_t child = startSimulation(options, input, output);
+    writeCommands(input, commands);
+    readOutput(output, commands.size() + 1); // The prompt after the last command comes once it acted
+    ::kill(child, SIGKILL);
+    ::waitpid(child, nullptr, 0);
+    ::close(input);
+    ::close(output);
+}
+
+string makeTemporaryDirectory() {
+    char path[] = "/tmp/simulation-test-XXXXXX";
+    if (::mkdtemp(path) == nullptr) {
+        throw runtime_error("Unable to make a temporary directory");
+    }
+    return path;
+}
+
+vector<string> randomSession(const unsigned int seed, const int numOfCommands, const SessionMix &mix) {
+    const vector<string> policies = {"nve", "bal", "eco", "sus"};
+    vector<string> droppedNames;
+    for (const string &name : mix.snapshotNames) {
+        if (!name.empty()) droppedNames.push_back(name);
+    }
+    // Commands of each kind, in proportion to their weights
+    enum class Kind { STEP, PLAN, SETTLEMENT, FACILITY, CHANGE_POLICY, BACKUP, RESTORE, DROP, UNDO, IMAGE, PLAN_STATUS, LOG };
+    vector<pair<Kind, unsigned int>> weights = {{Kind::STEP, 6}, {Kind::PLAN, 2}, {Kind::SETTLEMENT, 1}, {Kind::FACILITY, 1},
+                                                {Kind::CHANGE_POLICY, 2}};
+    if (!mix.snapshotNames.empty()) {
+        weights.insert(weights.end(), {{Kind::BACKUP, 4}, {Kind::RESTORE, 3}});
+    }
+    if (mix.dropsSnapshots && !droppedNames.empty()) weights.push_back({Kind::DROP, 1});
+    if (mix.undoes) weights.push_back({Kind::UNDO, 1});
+    if (!mix.imagePath.empty()) weights.push_back({Kind::IMAGE, 1});
+    if (mix.prints) weights.insert(weights.end(), {{Kind::PLAN_STATUS, 2}, {Kind::LOG, 1}});
+    unsigned int totalWeight = 0;
+    for (const pair<Kind, unsigned int> &weight : weights) {
+        totalWeight += weight.second;
+    }
+
+    mt19937 random(seed);
+    vector<string> settlements = {"KfarSPL", "KiryatSPL", "BeitSPL"};
+    int numOfPlans = 2; // The configuration's
+    vector<string> commands;
+    for (size_t i = 0; i < policies.size(); i++) {
+        commands.push_back("plan " + settlements[i % settlements.size()] + " " + policies[i]);
+        numOfPlans++;
+    }
+    for (int i = 0; i < numOfCommands; i++) {
+        unsigned int choice = random() % totalWeight;
+        size_t kind = 0;
+        while (choice >= weights[kind].second) {
+            choice -= weights[kind].second;
+            kind++;
+        }
+        switch (weights[kind].first) {
+            case Kind::STEP:
+                commands.push_back("step " + to_string(1 + random() % 30));
+                break;
+            case Kind::PLAN:
+                commands.push_back("plan " + settlements[random() % settlements.size()] + " " + policies[random() % policies.size()]);
+                numOfPlans++;
+                break;
+            case Kind::SETTLEMENT:
+                settlements.push_back("Settlement" + to_string(i));
+                commands.push_back("settlement " + settlements.back() + " " + to_string(random() % 3));
+                break;
+            case Kind::FACILITY: {
+                string scores;
+                for (int score = 0; score < 3; score++) {
+                    scores += " " + to_string(random() % 4);
+                }
+                commands.push_back("facility Facility" + to_string(i) + " " + to_string(random() % 3) + " " + to_string(1 + random() % 4) + scores);
+                break;
+            }
+            case Kind::CHANGE_POLICY: // Now and then a plan that doesn't exist (any more)
+                commands.push_back("changePolicy " + to_string(random() % (numOfPlans + 1)) + " " + policies[random() % policies.size()]);
+                break;
+            case Kind::BACKUP:
+            case Kind::RESTORE: {
+                const string &name = mix.snapshotNames[random() % mix.snapshotNames.size()];
+                commands.push_back(string(weights[kind].first == Kind::BACKUP ? "backup" : "restore") + (name.empty() ? "" : " " + name));
+                commands.insert(commands.end(), mix.probe.begin(), mix.probe.end());
+                break;
+            }
+            case Kind::DROP:
+                commands.push_back("dropSnapshot " + droppedNames[random() % droppedNames.size()]);
+                break;
+            case Kind::UNDO:
+                commands.push_back("undo " + to_string(1 + random() % 3));
+                break;
+            case Kind::IMAGE:
+                commands.push_back(random() % 2 == 0 ? "save " + mix.imagePath : "load " + mix.imagePath);
+                break;
+            case Kind::PLAN_STATUS:
+                commands.push_back("planStatus " + to_string(random() % (numOfPlans + 1)));
+                break;
+            case Kind::LOG:
+                commands.push_back("log");
+                break;
+        }
+    }
+    return commands;
+}
+
+// Runs every test, from the directory of the makefile (see 'make test')
+int main() {
+    const pair<const char*, void(*)()> tests[] = {
+        {"ActionLog", testActionLog},
+        {"Compare", testCompare},
+        {"FacilityPool", testFacilityPool},
+        {"ParallelStep", testParallelStep},
+        {"Replay", testReplay},
+        {"ScoreIndex", testScoreIndex},
+        {"SimulationImage", testSimulationImage},
+        {"Snapshots", testSnapshots},
+        {"UndoJournal", testUndoJournal},
+        {"WriteAheadLog", testWriteAheadLog},
+    };
+    ::signal(SIGPIPE, SIG_IGN); // A simulation that dies early shows up as a failed check instead
+    for (const pair<const char*, void(*)()> &test : tests) {
+        cout << test.first << endl;
+        try {
+            test.second();
+        } catch (const exception &e) {
+            check(false, string(test.first) + " threw: " + e.what());
+        }
+    }
+    cout << numOfChecks << " checks, " << numOfFailures << " failed" << endl;
+    return numOfFailures == 0 ? 0 : 1;
+}
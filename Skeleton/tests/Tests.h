@@ -0,0 +1,53 @@
+#pragma once
+#include "Simulation.h"
+#include <string>
+#include <vector>
+
+using namespace std;
+using std::string;
+using std::vector;
+
+// The configuration the tests start from, in the makefile's directory
+extern const char *const configurationPath;
+
+// Checks a condition, reporting what was checked if it doesn't hold. Any failed check fails the run (see TestMain.cpp).
+void check(const bool condition, const string &what);
+
+// Runs bin/simulation on the configuration with the given options, entering the commands then close.
+// Returns what it printed in response to each command, close excluded.
+vector<string> runSimulation(const vector<string> &options, const vector<string> &commands);
+
+// The same, on a simulation built here, in this process
+vector<string> runCommands(Simulation &simulation, const vector<string> &commands);
+
+// The same as runSimulation, but the simulation is killed once it has acted on the commands, as a crash would end it
+void crashSimulation(const vector<string> &options, const vector<string> &commands);
+
+// A new directory for a test's files
+string makeTemporaryDirectory();
+
+// What a random session does besides stepping, adding settlements, facilities and plans, and changing policies
+struct SessionMix {
+    vector<string> snapshotNames; // Backed up to and restored from, "" being the unnamed backup
+    bool dropsSnapshots;          // Drops the named ones too
+    bool undoes;
+    string imagePath;             // Images are saved there and loaded from there, unless empty
+    bool prints;                  // planStatus and log
+    vector<string> probe;         // Entered after each backup and restore
+};
+
+// A session of numOfCommands random commands (probes not counted) of the mix, the same for the same seed.
+// It starts with a plan of each policy, so every policy is stepped, backed up and restored.
+vector<string> randomSession(const unsigned int seed, const int numOfCommands, const SessionMix &mix);
+
+// The tests, one file each
+void testActionLog();
+void testCompare();
+void testFacilityPool();
+void testParallelStep();
+void testReplay();
+void testScoreIndex();
+void testSimulationImage();
+void testSnapshots();
+void testUndoJournal();
+void testWriteAheadLog();
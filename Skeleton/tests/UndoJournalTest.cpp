@@ -0,0 +1,57 @@
+#include "Tests.h"
+
+namespace {
+
+// Selects the first facility a number of times, then throws, as a policy that fails partway through a step would
+class FailingSelection final : public SelectionPolicy {
+    public:
+        FailingSelection(const int numOfSelections) : numOfSelections(numOfSelections) {}
+        const FacilityType &selectFacility(const vector<FacilityType> &facilitiesOptions) override {
+            return facilitiesOptions[selectIndex()];
+        }
+        void selectFacilities(const vector<FacilityType> &, const int numOfFacilities, vector<int> &selected) override {
+            for (int i = 0; i < numOfFacilities; i++) {
+                selected.push_back(selectIndex());
+            }
+        }
+        bool canSelect(const vector<FacilityType> &facilitiesOptions) const override { return !facilitiesOptions.empty(); }
+        bool isRoundRobin() const override { return false; }
+        int getLastSelectedIndex() const override { return 0; }
+        const string toString() const override { return "fail"; }
+        FailingSelection *clone() const override { return new FailingSelection(*this); }
+        void save(ImageWriter &writer) const override { writer.writeInt(numOfSelections); }
+        void load(ImageReader &reader, const vector<FacilityType> &) override { numOfSelections = reader.readInt(); }
+    private:
+        int selectIndex() {
+            if (numOfSelections-- <= 0) {
+                throw runtime_error("Selection failed");
+            }
+            return 0;
+        }
+        int numOfSelections;
+};
+
+// A simulation with the configuration's plans, then a plan that fails on its first step
+Simulation *failingSimulation() {
+    Simulation *simulation = new Simulation(configurationPath);
+    simulation->setUndoMemoryLimit(size_t(64) << 20);
+    simulation->addPlan(simulation->getSettlement("BeitSPL"), new FailingSelection(0));
+    return simulation;
+}
+
+}
+
+// A step that throws once some plans stepped is journaled like any command, so undoing it takes back what it changed
+// and nothing before it
+void testUndoJournal() {
+    Simulation *failed = failingSimulation();
+    vector<string> responses = runCommands(*failed, {"plan KfarSPL nve", "step 1", "undo 1", "planStatus 0", "planStatus 3"});
+    delete failed;
+    check(responses.size() == 5 && responses[1] == "Error: Selection failed\n", "the step fails");
+
+    Simulation *notStepped = failingSimulation();
+    vector<string> expected = runCommands(*notStepped, {"plan KfarSPL nve", "planStatus 0", "planStatus 3"});
+    delete notStepped;
+    check(responses.size() == 5 && expected.size() == 3 && responses[3] == expected[1] && responses[4] == expected[2],
+          "undo 1 takes back the failed step, and only it");
+}
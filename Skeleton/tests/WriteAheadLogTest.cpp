@@ -0,0 +1,82 @@
+#include "Tests.h"
+#include <algorithm>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+// What the state and the log look like: each plan's status, then the log
+const vector<string> probe = {"planStatus 0", "planStatus 1", "log"};
+
+vector<string> concatenate(vector<string> first, const vector<string> &second) {
+    first.insert(first.end(), second.begin(), second.end());
+    return first;
+}
+
+// The responses to the probe, entered after the commands in a session that doesn't crash
+vector<string> probeAfter(const vector<string> &commands) {
+    vector<string> responses = runSimulation({}, concatenate(commands, probe));
+    return vector<string>(responses.end() - min(responses.size(), probe.size()), responses.end());
+}
+
+bool exists(const string &path) {
+    struct stat status;
+    return ::stat(path.c_str(), &status) == 0;
+}
+
+// Recovering from a log adds the recovered session's commands to it, so checks recover from a copy
+string copyOf(const string &path) {
+    string copyPath = path + ".copy";
+    ifstream original(path, ios::binary);
+    ofstream copy(copyPath, ios::binary | ios::trunc);
+    copy << original.rdbuf();
+    return copyPath;
+}
+
+off_t sizeOf(const string &path) {
+    struct stat status;
+    return (::stat(path.c_str(), &status) == 0) ? status.st_size : -1;
+}
+
+}
+
+// Sessions killed after their commands acted, then recovered from their write-ahead logs, against the same commands
+// entered into one session
+void testWriteAheadLog() {
+    string directory = makeTemporaryDirectory();
+    string walPath = directory + "/session.wal";
+    string imagePath = directory + "/campaign.img";
+    string printedPath = directory + "/printed.img";
+    vector<string> options = {"--wal", walPath, "--wal-sync-count", "1", "--wal-sync-interval", "0"};
+    vector<string> copyOptions = {"--wal", walPath + ".copy"};
+
+    // The image the load read is overwritten afterwards: recovery has to load what it held then
+    vector<string> first = {"step 1", "save " + imagePath, "step 2", "load " + imagePath, "step 3", "save " + imagePath,
+                            "planStatus 0", "compare 0 2", "save " + printedPath, "stats"};
+    crashSimulation(options, first);
+    check(::unlink(printedPath.c_str()) == 0, "save wrote its image before the crash");
+    copyOf(walPath);
+    vector<string> recovered = runSimulation(copyOptions, probe);
+    check(!exists(printedPath), "recovery doesn't save again");
+    check(recovered == probeAfter(first), "recovery after a load matches the session that didn't crash");
+
+    // The recovered session goes on, and is recovered again with a record cut short by the crash at its end
+    vector<string> second = {"backup", "plan KfarSPL nve", "step 4", "load " + directory + "/missing.img", "undo", "restore", "step 1"};
+    crashSimulation(options, second);
+    off_t intactSize = sizeOf(walPath);
+    {
+        ofstream wal(walPath, ios::binary | ios::app);
+        wal.write("\x20\x00\x00\x00step", 8);
+    }
+    copyOf(walPath);
+    crashSimulation(copyOptions, {});
+    check(sizeOf(walPath + ".copy") == intactSize, "the torn record is cut off");
+    check(runSimulation(copyOptions, probe) == probeAfter(concatenate(first, second)),
+          "recovery after a torn record matches the session that didn't crash");
+
+    ::unlink(walPath.c_str());
+    ::unlink((walPath + ".copy").c_str());
+    ::unlink(imagePath.c_str());
+    ::rmdir(directory.c_str());
+}